@@ -0,0 +1,34 @@
+#pragma once
+
+// Timing helpers shared by the bench/ programs. Each program times the
+// current code against a copy of the approach it replaced and prints one
+// line per case.
+
+#include <chrono>
+#include <cstdio>
+
+namespace BENCH {
+
+    // Results are added here so the compiler cannot drop the timed work
+    inline volatile size_t sink = 0;
+
+    // Average nanoseconds per call of fn(i), after a short warm-up
+    template <typename Fn>
+    double ns_per_op(size_t iterations, Fn&& fn) {
+        for (size_t i = 0; i < iterations / 10; ++i) fn(i);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) fn(i);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+
+    inline void header(const char* title) {
+        std::printf("%s\n  %-38s %12s %12s %8s\n", title, "", "before", "after", "speedup");
+    }
+
+    inline void report(const char* name, double before_ns, double after_ns, const char* unit = "ns") {
+        std::printf("  %-38s %9.1f %-2s %9.1f %-2s %7.2fx\n",
+                    name, before_ns, unit, after_ns, unit, before_ns / after_ns);
+    }
+
+} // namespace BENCH
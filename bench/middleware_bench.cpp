@@ -0,0 +1,80 @@
+// Middleware pipeline overhead per request: building a typical JSON
+// response alone, then with five middlewares run through MiddlewareChain
+// (run_before + run_after). Once with no-op middlewares, which is the
+// chain's own cost, and once with the shipped request-id, timing, CORS
+// and auth middlewares plus a no-op.
+//
+// Build and run with `make bench`.
+
+#include "bench.hpp"
+
+#include "core/middleware.hpp"
+#include "middleware/auth_middleware.hpp"
+#include "middleware/cors_middleware.hpp"
+#include "middleware/request_id_middleware.hpp"
+#include "middleware/timing_middleware.hpp"
+
+#include <memory>
+
+namespace {
+
+    constexpr size_t ITERATIONS = 3000000;
+
+    class NoopMiddleware {
+    public:
+        bool before(CORE::Request&, CORE::Response&) { return true; }
+        void after(const CORE::Request&, CORE::Response&) {}
+    };
+
+    // What a handler does for /api/status, without the middleware
+    void build_response(CORE::Response& res) {
+        res.headers.reserve(512);
+        res.status_code = 200;
+        res.headers.set(CORE::HeaderId::SERVER, CORE::SERVER_NAME);
+        res.headers.set(CORE::HeaderId::CONNECTION, "keep-alive");
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, "application/json");
+        res.body = "{\"message\": \"Hello from JSON API!\"}";
+    }
+
+    double ns_per_request(const CORE::MiddlewareChain* chain, CORE::Request& req) {
+        return BENCH::ns_per_op(ITERATIONS, [&](size_t) {
+            CORE::Response res;
+            size_t entered = 0;
+            if (!chain || chain->run_before(req, res, entered)) {
+                build_response(res);
+            }
+            if (chain) {
+                chain->run_after(req, res, entered);
+            }
+            BENCH::sink = BENCH::sink + res.body.size();
+        });
+    }
+
+} // namespace
+
+int main() {
+    CORE::Request req;
+    req.method = "GET";
+    req.method_id = CORE::Method::GET;
+    req.path = "/api/status";
+    req.headers.set("Authorization", "Bearer secret-token");
+    req.headers.set("Origin", "https://app.example");
+
+    CORE::MiddlewareChain noops;
+    for (int i = 0; i < 5; ++i) {
+        noops.add(std::make_shared<NoopMiddleware>());
+    }
+
+    CORE::MiddlewareChain shipped;
+    shipped.add(std::make_shared<RequestIdMiddleware>());
+    shipped.add(std::make_shared<TimingMiddleware>());
+    shipped.add(std::make_shared<CorsMiddleware>("https://app.example"));
+    shipped.add(std::make_shared<BearerAuthMiddleware>("secret-token", "/api"));
+    shipped.add(std::make_shared<NoopMiddleware>());
+
+    BENCH::header("middleware per request (before = no middleware)");
+    double none = ns_per_request(nullptr, req);
+    BENCH::report("5 no-op middlewares", none, ns_per_request(&noops, req));
+    BENCH::report("request-id, timing, CORS, auth, no-op", none, ns_per_request(&shipped, req));
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Static file path handling: PathSecurity::resolve_request_path (decode
+// and normalize in place, in a reused buffer) against the url_decode +
+// split/rebuild through a vector<string> it replaced, and
+// RootDirectory::open beneath a root descriptor against a plain open()
+// of the joined path.
+//
+// Build and run with `make bench`.
+
+#include "bench.hpp"
+
+#include "utils/path_security.hpp"
+#include "utils/root_directory.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr size_t RESOLVE_ITERATIONS = 2000000;
+    constexpr size_t OPEN_ITERATIONS = 200000;
+
+    // Before: decode into a new string ('+' as space, as it did then)
+    std::string copy_url_decode(const std::string& encoded) {
+        std::string decoded;
+        decoded.reserve(encoded.size());
+        for (size_t i = 0; i < encoded.size(); ++i) {
+            if (encoded[i] == '%' && i + 2 < encoded.size()) {
+                char hex[3] = {encoded[i + 1], encoded[i + 2], '\0'};
+                char* end;
+                long value = std::strtol(hex, &end, 16);
+                if (end == hex + 2) {
+                    decoded += static_cast<char>(value);
+                    i += 2;
+                } else {
+                    decoded += encoded[i];
+                }
+            } else if (encoded[i] == '+') {
+                decoded += ' ';
+            } else {
+                decoded += encoded[i];
+            }
+        }
+        return decoded;
+    }
+
+    bool safe_component(const std::string& component) {
+        for (char c : component) {
+            if ((c < 32 && c != '\t') || c == '<' || c == '>' || c == ':' || c == '"' ||
+                c == '|' || c == '?' || c == '*' || c == '\\') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Before: split into components, check each, join them back up
+    std::string split_resolve(const std::string& requested_path, const std::string& document_root) {
+        std::vector<std::string> components;
+        std::string current;
+        for (char c : requested_path) {
+            if (c == '/') {
+                if (!current.empty()) components.push_back(current);
+                current.clear();
+            } else {
+                current += c;
+            }
+        }
+        if (!current.empty()) components.push_back(current);
+
+        std::string path = document_root;
+        for (const std::string& component : components) {
+            if (component == ".." || !safe_component(component)) return "";
+            if (component == ".") continue;
+            path += component;
+            path += '/';
+        }
+        if (!requested_path.empty() && requested_path.back() != '/' && path.back() == '/') {
+            path.pop_back();
+        }
+        return path;
+    }
+
+    // A throwaway document root holding the benchmark's one file
+    struct ScratchRoot {
+        std::string root;
+
+        ScratchRoot() {
+            char dir[] = "/tmp/spp-path-bench-XXXXXX";
+            if (!mkdtemp(dir)) {
+                std::perror("mkdtemp");
+                std::exit(1);
+            }
+            root = std::string(dir) + "/";
+            mkdir((root + "assets").c_str(), 0755);
+            mkdir((root + "assets/css").c_str(), 0755);
+            int fd = ::open((root + "assets/css/site main.css").c_str(), O_WRONLY | O_CREAT, 0644);
+            close(fd);
+        }
+
+        ~ScratchRoot() {
+            unlink((root + "assets/css/site main.css").c_str());
+            rmdir((root + "assets/css").c_str());
+            rmdir((root + "assets").c_str());
+            rmdir(root.c_str());
+        }
+    };
+
+} // namespace
+
+int main() {
+    ScratchRoot scratch;
+    const std::string& root = scratch.root;
+    const std::string target = "/assets/css/site%20main.css";
+
+    BENCH::header("static file path resolution");
+
+    double before = BENCH::ns_per_op(RESOLVE_ITERATIONS, [&](size_t) {
+        BENCH::sink = BENCH::sink + split_resolve(copy_url_decode(target), root).size();
+    });
+    std::string resolved;
+    double after = BENCH::ns_per_op(RESOLVE_ITERATIONS, [&](size_t) {
+        UTILS::PathSecurity::resolve_request_path(target, root, resolved);
+        BENCH::sink = BENCH::sink + resolved.size();
+    });
+    BENCH::report("resolve request path", before, after);
+
+    UTILS::RootDirectory directory(root);
+    const char* relative = resolved.c_str() + root.size();
+    auto open_and_close = [](int fd) {
+        if (fd == -1) {
+            std::perror("open");
+            std::exit(1);
+        }
+        close(fd);
+    };
+    before = BENCH::ns_per_op(OPEN_ITERATIONS, [&](size_t) {
+        open_and_close(::open(resolved.c_str(), O_RDONLY | O_CLOEXEC));
+    });
+    after = BENCH::ns_per_op(OPEN_ITERATIONS, [&](size_t) {
+        open_and_close(directory.open(relative));
+    });
+    BENCH::report("open beneath root", before, after);
+    return 0;
+}
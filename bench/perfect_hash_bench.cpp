@@ -0,0 +1,98 @@
+// Method, header-name and MIME lookups: the compile-time perfect hash
+// tables against the string compares, linear scan and lowercase-copy map
+// lookup they replaced.
+//
+// Build and run with `make bench`.
+
+#include "bench.hpp"
+
+#include "core/headers.hpp"
+#include "core/http.hpp"
+#include "utils/mime_detector.hpp"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+    constexpr size_t ITERATIONS = 5000000;
+
+    // Before: a chain of compares in the parser
+    bool chained_method_check(const std::string& method) {
+        return method == "GET" || method == "POST" || method == "PUT" ||
+               method == "DELETE" || method == "HEAD" || method == "OPTIONS" ||
+               method == "PATCH" || method == "TRACE" || method == "CONNECT";
+    }
+
+    // Before: a case-insensitive compare against every known name
+    CORE::HeaderId scanned_header_id(std::string_view name) {
+        for (size_t i = 0; i < CORE::KNOWN_HEADER_COUNT; ++i) {
+            if (UTILS::iequals(name, CORE::KNOWN_HEADER_NAMES[i])) {
+                return static_cast<CORE::HeaderId>(i);
+            }
+        }
+        return CORE::HeaderId::UNKNOWN;
+    }
+
+    // Before: lowercase a copy of the extension, then a string-keyed map
+    const std::unordered_map<std::string, std::string> MIME_MAP = {
+        {"html", "text/html"}, {"htm", "text/html"}, {"css", "text/css"},
+        {"js", "text/javascript"}, {"json", "application/json"}, {"xml", "text/xml"},
+        {"txt", "text/plain"}, {"jpg", "image/jpeg"}, {"jpeg", "image/jpeg"},
+        {"png", "image/png"}, {"gif", "image/gif"}, {"webp", "image/webp"},
+        {"svg", "image/svg+xml"}, {"ico", "image/x-icon"}, {"woff", "font/woff"},
+        {"woff2", "font/woff2"}, {"ttf", "font/ttf"}, {"pdf", "application/pdf"},
+        {"zip", "application/zip"}, {"gz", "application/gzip"}, {"mp4", "video/mp4"},
+    };
+
+    std::string mapped_mime_type(const std::string& file_path) {
+        size_t dot = file_path.find_last_of('.');
+        if (dot == std::string::npos) return "application/octet-stream";
+        std::string extension = file_path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        auto it = MIME_MAP.find(extension);
+        return it != MIME_MAP.end() ? it->second : "application/octet-stream";
+    }
+
+    const std::string METHODS[] = {"GET", "POST", "HEAD", "OPTIONS", "CONNECT", "BREW"};
+    const std::string HEADERS[] = {"Host", "user-agent", "Accept-Encoding", "If-None-Match",
+                                   "Connection", "X-Request-Id", "content-length", "Cookie"};
+    const std::string PATHS[] = {"/index.html", "/css/Site.CSS", "/js/app.bundle.js",
+                                 "/img/Logo.PNG", "/fonts/inter.woff2", "/download/data.bin"};
+
+    template <typename T, size_t N>
+    const T& pick(const T (&items)[N], size_t i) {
+        return items[i % N];
+    }
+
+} // namespace
+
+int main() {
+    BENCH::header("perfect hash lookups");
+
+    double before = BENCH::ns_per_op(ITERATIONS, [](size_t i) {
+        BENCH::sink = BENCH::sink + chained_method_check(pick(METHODS, i));
+    });
+    double after = BENCH::ns_per_op(ITERATIONS, [](size_t i) {
+        BENCH::sink = BENCH::sink + static_cast<size_t>(CORE::parse_method(pick(METHODS, i)));
+    });
+    BENCH::report("method", before, after);
+
+    before = BENCH::ns_per_op(ITERATIONS, [](size_t i) {
+        BENCH::sink = BENCH::sink + static_cast<size_t>(scanned_header_id(pick(HEADERS, i)));
+    });
+    after = BENCH::ns_per_op(ITERATIONS, [](size_t i) {
+        BENCH::sink = BENCH::sink + static_cast<size_t>(CORE::lookup_header_id(pick(HEADERS, i)));
+    });
+    BENCH::report("header name id", before, after);
+
+    before = BENCH::ns_per_op(ITERATIONS, [](size_t i) {
+        BENCH::sink = BENCH::sink + mapped_mime_type(pick(PATHS, i)).size();
+    });
+    after = BENCH::ns_per_op(ITERATIONS, [](size_t i) {
+        BENCH::sink = BENCH::sink + UTILS::MimeTypeDetector::get_mime_type(pick(PATHS, i)).size();
+    });
+    BENCH::report("mime type by extension", before, after);
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Response serialization and send: ResponseWriter (head rendered into a
+// reused buffer, head and body sent together by sendmsg) against the
+// ostringstream full copy and send loop it replaced. Responses go over a
+// socketpair to a reader thread that drains them.
+//
+// Build and run with `make bench`.
+
+#include "bench.hpp"
+
+#include "core/response_writer.hpp"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+    // Before: the whole response copied into one string, then sent
+    std::string stream_serialize(const CORE::Response& response) {
+        std::ostringstream oss;
+        oss << "HTTP/1.1 " << response.status_code << " " << response.status_text << "\r\n";
+        for (const auto& [name, value] : response.headers) {
+            oss << name << ": " << value << "\r\n";
+        }
+        oss << "\r\n" << response.body;
+        return oss.str();
+    }
+
+    bool stream_send(int fd, const CORE::Response& response) {
+        std::string bytes = stream_serialize(response);
+        size_t total = 0;
+        while (total < bytes.size()) {
+            ssize_t sent = send(fd, bytes.data() + total, bytes.size() - total, MSG_NOSIGNAL);
+            if (sent == -1) return false;
+            total += static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool writer_send(int fd, const CORE::Response& response) {
+        const std::string& head = CORE::ResponseWriter::render_head(response);
+        uint64_t sent = 0;
+        return CORE::ResponseWriter::write_some(fd, head, response, sent) == CORE::WriteStatus::DONE;
+    }
+
+    CORE::Response make_response(size_t body_size) {
+        CORE::Response response;
+        response.status_code = 200;
+        response.status_text = "OK";
+        response.headers.set(CORE::HeaderId::CONTENT_TYPE, "application/octet-stream");
+        response.headers.set(CORE::HeaderId::SERVER, "see-plus-plus/1.0");
+        response.headers.set(CORE::HeaderId::CONNECTION, "keep-alive");
+        response.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(body_size));
+        response.body.assign(body_size, 'x');
+        return response;
+    }
+
+    // Microseconds per response sent to a reader that drains everything
+    template <typename Send>
+    double us_per_response(const CORE::Response& response, size_t iterations, Send send_response) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+            std::perror("socketpair");
+            std::exit(1);
+        }
+        std::thread reader([fd = fds[1]] {
+            std::vector<char> buffer(1 << 20);
+            while (read(fd, buffer.data(), buffer.size()) > 0) {}
+        });
+
+        double ns = BENCH::ns_per_op(iterations, [&](size_t) {
+            if (!send_response(fds[0], response)) {
+                std::perror("send");
+                std::exit(1);
+            }
+        });
+
+        shutdown(fds[0], SHUT_WR);
+        reader.join();
+        close(fds[0]);
+        close(fds[1]);
+        return ns / 1000.0;
+    }
+
+} // namespace
+
+int main() {
+    BENCH::header("response serialization and send");
+
+    struct Case {
+        const char* name;
+        size_t body_size;
+        size_t iterations;
+    };
+    const Case cases[] = {
+        {"512 B body", 512, 20000},
+        {"64 KiB body", 64 * 1024, 5000},
+        {"5 MiB body", 5 * 1024 * 1024, 100},
+    };
+    for (const Case& c : cases) {
+        CORE::Response response = make_response(c.body_size);
+        double before = us_per_response(response, c.iterations, stream_send);
+        double after = us_per_response(response, c.iterations, writer_send);
+        BENCH::report(c.name, before, after, "us");
+    }
+    return 0;
+}
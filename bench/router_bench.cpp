@@ -0,0 +1,111 @@
+// Route matching with 1,280 routes: the radix-tree RouteSnapshot against
+// the exact-match map plus linear scan of std::regex pattern routes it
+// replaced. Parameterized routes are ":id" captures in the tree and
+// "([^/]+)" patterns in the baseline.
+//
+// Build and run with `make bench`.
+
+#include "bench.hpp"
+
+#include "core/router.hpp"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // Before: exact routes in a hash map, then every pattern in turn
+    class RegexRouter {
+    public:
+        void add_route(const std::string& method, const std::string& path) {
+            exact_[method + ' ' + path] = true;
+        }
+
+        void add_pattern_route(const std::string& method, const std::string& pattern) {
+            patterns_.push_back({method, std::regex(pattern)});
+        }
+
+        bool has_route(const std::string& method, const std::string& path) const {
+            if (exact_.count(method + ' ' + path)) {
+                return true;
+            }
+            for (const Pattern& pattern : patterns_) {
+                if (pattern.method == method && std::regex_match(path, pattern.regex)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct Pattern {
+            std::string method;
+            std::regex regex;
+        };
+
+        std::unordered_map<std::string, bool> exact_;
+        std::vector<Pattern> patterns_;
+    };
+
+    class NoopController : public CORE::Controller {
+    public:
+        void handle(const CORE::Request&, CORE::Response&) override {}
+    };
+
+    const char* const RESOURCES[] = {"users", "orders", "items", "teams", "repos", "files", "events", "tags"};
+    constexpr int VERSIONS = 40;
+
+} // namespace
+
+int main() {
+    CORE::RouteSnapshot tree;
+    RegexRouter regex;
+    auto controller = std::make_shared<NoopController>();
+    size_t count = 0;
+    for (const char* resource : RESOURCES) {
+        for (int version = 0; version < VERSIONS; ++version) {
+            std::string base = "/api/v" + std::to_string(version) + "/" + resource;
+            tree.add_route("GET", base, controller);
+            tree.add_route("POST", base, controller);
+            tree.add_route("GET", base + "/:id", controller);
+            tree.add_route("GET", base + "/:id/history", controller);
+            regex.add_route("GET", base);
+            regex.add_route("POST", base);
+            regex.add_pattern_route("GET", base + "/([^/]+)");
+            regex.add_pattern_route("GET", base + "/([^/]+)/history");
+            count += 4;
+        }
+    }
+
+    std::string title = "route matching, " + std::to_string(count) + " routes";
+    BENCH::header(title.c_str());
+    struct Case {
+        const char* name;
+        const char* path;
+    };
+    const Case cases[] = {
+        {"static route", "/api/v3/users"},
+        {"first capture route", "/api/v0/users/17"},
+        {"last capture route", "/api/v39/tags/12345/history"},
+        {"miss", "/nope/nothing"},
+    };
+    const std::string method = "GET";
+    for (const Case& c : cases) {
+        const std::string path = c.path;
+        if (tree.has_route(method, path) != regex.has_route(method, path)) {
+            std::fprintf(stderr, "routers disagree on %s\n", c.path);
+            return 1;
+        }
+        double before = BENCH::ns_per_op(2000, [&](size_t) {
+            BENCH::sink = BENCH::sink + regex.has_route(method, path);
+        });
+        double after = BENCH::ns_per_op(2000000, [&](size_t) {
+            BENCH::sink = BENCH::sink + tree.has_route(method, path);
+        });
+        BENCH::report(c.name, before, after);
+    }
+    return 0;
+}
@@ -6,7 +6,7 @@ public:
     void handle(const CORE::Request& req, CORE::Response& res) override {
         res.status_code = 200;
         res.status_text = "OK";
-        res.headers["Content-Type"] = "text/html";
+        res.headers.set("Content-Type", "text/html");
         res.body = R"(
 <!DOCTYPE html>
 <html>
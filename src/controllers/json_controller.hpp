@@ -6,7 +6,7 @@ public:
     void handle(const CORE::Request& req, CORE::Response& res) override {
         res.status_code = 200;
         res.status_text = "OK";
-        res.headers["Content-Type"] = "application/json";
+        res.headers.set("Content-Type", "application/json");
         res.body = R"({
     "message": "Hello from JSON API!",
     "method": ")" + req.method + R"(",
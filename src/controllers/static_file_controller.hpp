@@ -2,129 +2,623 @@
 
 #include "../core/controller.hpp"
 #include "../core/http.hpp"
+#include "../core/prebuilt_responses.hpp"
+#include "../core/logger.hpp"
 #include "../utils/mime_detector.hpp"
 #include "../utils/path_security.hpp"
 #include "../utils/file_reader.hpp"
+#include "../utils/byte_range.hpp"
+#include "../utils/file_cache.hpp"
+#include "../utils/open_file_cache.hpp"
+#include "../utils/content_coding.hpp"
+#include "../utils/etag_cache.hpp"
+#include "../utils/root_directory.hpp"
+#include "../utils/asset_bundle.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
 
 class StaticFileController : public CORE::Controller {
 public:
 
-    explicit StaticFileController(const std::string& document_root) 
-        : document_root_(document_root) {
+    // With a `bundle_path`, files are served from that packed snapshot of
+    // the document root (see UTILS::AssetBundle) instead of from disk
+    explicit StaticFileController(const std::string& document_root, const std::string& bundle_path = "") 
+        : document_root_(with_trailing_slash(document_root)), root_(document_root_), 
+          file_cache_(document_root) {
         
-        if (!document_root_.empty() && document_root_.back() != '/') {
-            document_root_ += '/';
+        if (!root_.valid()) {
+            LOG_ERROR("Cannot open document root", document_root_);
+        }
+        if (!bundle_path.empty()) {
+            bundle_ = std::make_unique<UTILS::AssetBundle>(bundle_path);
+            if (!bundle_->valid()) {
+                LOG_ERROR("Cannot load asset bundle, serving from disk:", bundle_->error());
+                bundle_.reset();
+            } else {
+                std::cout << "📦 StaticFileController: " << bundle_->size() 
+                          << " files from bundle " << bundle_path << std::endl;
+            }
         }
         
         std::cout << "📁 StaticFileController: serving files from " 
-                  << document_root_ << std::endl;
+                  << document_root_ << (file_cache_.is_watching() ? " (cache: inotify)" : " (cache: stat)")
+                  << std::endl;
     }
     
     void handle(const CORE::Request& req, CORE::Response& res) override {
-        std::string decoded_path = UTILS::PathSecurity::url_decode(req.path);
+        // Reused per worker thread, so resolving a path does not allocate
+        thread_local std::string path;
         
-        std::string safe_file_path = UTILS::PathSecurity::resolve_safe_path(
-            decoded_path, document_root_);
-        
-        if (safe_file_path.empty()) {
-            send_error_response(res, 403, "Forbidden", 
-                "Access to the requested path is not allowed");
+        auto resolved = UTILS::PathSecurity::resolve_request_path(req.path, document_root_, path);
+        if (!resolved.success) {
+            LOG_WARN("🚨 Rejected path", req.path, "-", resolved.error_message);
+            send_error_response(res, 403);
             return;
         }
         
-        if (decoded_path.back() == '/') {
-            std::string index_path = UTILS::PathSecurity::resolve_safe_path(
-                decoded_path + "index.html", document_root_);
-                
-            if (!index_path.empty() && UTILS::PathSecurity::file_exists_and_readable(index_path)) {
-                safe_file_path = index_path;
-            } else {
-                send_directory_response(req, res, decoded_path);
-                return;
-            }
+        // Cache hits are answered here. A miss needs open() and reads,
+        // which may wait on the disk, so it is finished on the I/O executor.
+        if (!respond(req, res, path, resolved.directory, false)) {
+            bool directory = resolved.directory;
+            res.io_work = [this, path = path, directory](const CORE::Request& req, CORE::Response& res) mutable {
+                respond(req, res, path, directory, true);
+            };
         }
+    }
+    
+    // Load `paths` (request paths such as "/css/app.css") into the caches,
+    // spread over `threads` threads: bodies of small files, open fds and
+    // the first READAHEAD_WINDOW of large ones, and gzip variants of text.
+    // Meant to run before the server accepts, so the first requests after
+    // a restart find warm caches. Returns how many files were loaded.
+    size_t warm_up(const std::vector<std::string>& paths, size_t threads = WARM_UP_THREADS) {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> loaded{0};
+        auto work = [&] {
+            std::string path;
+            for (size_t i = next++; i < paths.size(); i = next++) {
+                if (preload(paths[i], path)) ++loaded;
+            }
+        };
         
-        if (!UTILS::PathSecurity::file_exists_and_readable(safe_file_path)) {
-            send_error_response(res, 404, "Not Found", 
-                "The requested file could not be found");
-            return;
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads && i < paths.size(); ++i) {
+            workers.emplace_back(work);
         }
-        
-        if (handle_conditional_request(req, res, safe_file_path)) {
-            return;
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return loaded.load();
+    }
+    
+    // Record the SNAPSHOT_LIMIT most-requested cached files in
+    // `snapshot_path`, one request path per line, most hits first
+    bool save_snapshot(const std::string& snapshot_path) const {
+        std::vector<UTILS::PathHits> cached;
+        file_cache_.collect_hits(cached);
+        open_files_.collect_hits(cached);
+        std::sort(cached.begin(), cached.end(), [](const UTILS::PathHits& a, const UTILS::PathHits& b) {
+            return a.hits > b.hits;
+        });
+        if (cached.size() > SNAPSHOT_LIMIT) {
+            cached.resize(SNAPSHOT_LIMIT);
         }
         
-        serve_file(res, safe_file_path);
+        std::string temp_path = snapshot_path + ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::trunc);
+            for (const auto& entry : cached) {
+                // Cached keys are resolved paths; store what a client asks for
+                out << '/' << std::string_view(entry.path).substr(document_root_.size()) << '\n';
+            }
+            if (!out.flush()) {
+                return false;
+            }
+        }
+        return std::rename(temp_path.c_str(), snapshot_path.c_str()) == 0;
+    }
+    
+    static std::vector<std::string> load_snapshot(const std::string& snapshot_path) {
+        std::vector<std::string> paths;
+        std::ifstream in(snapshot_path);
+        std::string line;
+        while (std::getline(in, line) && paths.size() < SNAPSHOT_LIMIT) {
+            if (!line.empty()) paths.push_back(std::move(line));
+        }
+        return paths;
     }
     
 private:
     std::string document_root_;  
+    UTILS::RootDirectory root_;          // Files are only ever opened beneath this
+    UTILS::FileCache file_cache_;        // Small file bodies, in memory
+    UTILS::OpenFileCache open_files_;    // Open fds of large files, and known-missing paths
+    
+    UTILS::EncodedCache encoded_;        // gzip/br variants, by ETag of the original
+    UTILS::EtagCache etags_;             // Content hash ETags, per file version
+    std::unique_ptr<UTILS::AssetBundle> bundle_;  // If set, answers every lookup
+    
+    static std::string with_trailing_slash(std::string path) {
+        if (!path.empty() && path.back() != '/') {
+            path += '/';
+        }
+        return path;
+    }
+    
+    // Files below this are not worth compressing on the fly
+    static constexpr size_t MIN_COMPRESS_SIZE = 256;
     
-    void serve_file(CORE::Response& res, const std::string& file_path) {
-        auto file_info = UTILS::FileReader::read_file(file_path);
+    static constexpr size_t WARM_UP_THREADS = 4;
+    static constexpr size_t SNAPSHOT_LIMIT = 1024;
+    
+    // Bring one request path into the caches, as serving it would
+    bool preload(const std::string& request_path, std::string& path) {
+        auto resolved = UTILS::PathSecurity::resolve_request_path(request_path, document_root_, path);
+        if (!resolved.success) return false;
+        if (resolved.directory) {
+            if (path.back() != '/') path += '/';
+            path += "index.html";
+        }
         
-        if (!file_info.success) {
-            send_error_response(res, 500, "Internal Server Error", 
-                "Error reading file: " + file_info.error_message);
-            return;
+        LookupStatus status;
+        status.may_block = true;
+        uint64_t generation = file_cache_.generation();
+        auto file = find_file(path, generation, status);
+        if (!file) return false;
+        if (UTILS::MimeTypeDetector::is_compressible(file->mime_type)) {
+            find_variant(path, *file, UTILS::ContentCoding::BR, generation, status);
+            find_variant(path, *file, UTILS::ContentCoding::GZIP, generation, status);
         }
+        return true;
+    }
+    
+    // How a lookup that produced no file went
+    struct LookupStatus {
+        bool may_block = false;     // In: a miss may open and read files on this thread
+        bool needs_io = false;      // Out: a miss that was not resolved because it may not block
+        std::string error;          // Out: the file exists but could not be read
+    };
+    
+    // Answer for `path`, or the directory it names. Returns false, with
+    // `path` and `res` untouched, if that needs blocking I/O and !may_block.
+    bool respond(const CORE::Request& req, CORE::Response& res, std::string& path, 
+                 bool directory, bool may_block) {
+        LookupStatus status;
+        status.may_block = may_block;
         
-        res.status_code = 200;
-        res.status_text = "OK";
+        if (directory) {
+            size_t dir_length = path.size();
+            if (path.back() != '/') path += '/';
+            path += "index.html";
+            
+            bool served = serve_path(req, res, path, status);
+            path.resize(dir_length);
+            if (served) return true;
+            if (status.needs_io) return false;
+            
+            send_directory_response(req, res, path);
+            return true;
+        }
+        
+        if (serve_path(req, res, path, status)) return true;
+        if (status.needs_io) return false;
+        
+        send_error_response(res, 404);
+        return true;
+    }
+    
+    // Serve a file, or return false if it does not exist (or needs I/O)
+    bool serve_path(const CORE::Request& req, CORE::Response& res, const std::string& path,
+                    LookupStatus& status) {
+        uint64_t generation = file_cache_.generation();
+        auto file = find_file(path, generation, status);
+        if (!file) {
+            if (status.error.empty()) return false;
+            send_error_response(res, 500, "Internal Server Error", "Error reading file: " + status.error);
+            return true;
+        }
+        
+        if (!UTILS::MimeTypeDetector::is_compressible(file->mime_type)) {
+            serve_cached(req, res, *file);
+            return true;
+        }
         
-        res.headers["Content-Type"] = file_info.mime_type;
-        res.headers["Content-Length"] = std::to_string(file_info.file_size);
+        // Text types are negotiated: a .br or .gz sibling if one exists and
+        // the client takes it, otherwise gzip made on the fly
+        auto accepted = UTILS::AcceptedCodings::parse(req.headers.get(CORE::HeaderId::ACCEPT_ENCODING));
+        std::shared_ptr<const UTILS::CachedFile> variant;
+        UTILS::ContentCoding coding = UTILS::ContentCoding::IDENTITY;
+        if (accepted.br && (variant = find_variant(path, *file, UTILS::ContentCoding::BR, generation, status))) {
+            coding = UTILS::ContentCoding::BR;
+        } else if (!status.needs_io && accepted.gzip &&
+                   (variant = find_variant(path, *file, UTILS::ContentCoding::GZIP, generation, status))) {
+            coding = UTILS::ContentCoding::GZIP;
+        }
+        if (status.needs_io) return false;
         
-        res.headers["Server"] = "see-plus-plus/1.0";
+        serve_cached(req, res, variant ? *variant : *file);
+        if (variant) {
+            res.headers.set(CORE::HeaderId::CONTENT_ENCODING, UTILS::coding_name(coding));
+        }
+        res.headers.set(CORE::HeaderId::VARY, "Accept-Encoding");
+        return true;
+    }
+    
+    // Look a file up in the caches, opening it only on a miss. Returns null
+    // if it does not exist, if it could not be read (`status.error`), or
+    // if it is not cached and the caller may not block (`status.needs_io`).
+    // A hit touches no filesystem state. With a bundle loaded, only the
+    // bundle is consulted.
+    std::shared_ptr<const UTILS::CachedFile> find_file(const std::string& path, uint64_t generation,
+                                                       LookupStatus& status) {
+        if (bundle_) {
+            return bundle_->find(std::string_view(path).substr(document_root_.size()));
+        }
+        if (auto cached = file_cache_.find(path)) {
+            return cached;
+        }
+        
+        std::shared_ptr<const UTILS::CachedFile> file;
+        if (open_files_.find(path, generation, file)) {
+            return file;
+        }
         
-        res.headers["Last-Modified"] = UTILS::FileReader::format_http_date(file_info.last_modified);
-        res.headers["ETag"] = UTILS::FileReader::generate_etag(file_info.file_size, file_info.last_modified);
-        res.headers["Cache-Control"] = UTILS::FileReader::generate_cache_control(file_info.mime_type);
+        if (!status.may_block) {
+            status.needs_io = true;
+            return nullptr;
+        }
         
-        if (UTILS::StringUtils::starts_with(file_info.mime_type, "text/html")) {
-            res.headers["X-Content-Type-Options"] = "nosniff";
+        // Every key starts with document_root_ (see resolve_request_path)
+        auto file_info = UTILS::FileReader::open_file(root_, path.c_str() + document_root_.size());
+        if (!file_info.success) {
+            if (file_info.not_found) {
+                open_files_.insert(path, nullptr, generation);
+            } else {
+                status.error = file_info.error_message;
+            }
+            return nullptr;
         }
         
-        res.body = std::move(file_info.content);
+        file = load_file(path, file_info, generation);
+        if (!file) {
+            status.error = "read failed";
+            return nullptr;
+        }
         
-        std::cout << "✅ Served: " << file_path 
+        std::cout << "✅ Loaded: " << path 
                   << " (" << file_info.file_size << " bytes, " 
                   << file_info.mime_type << ")" << std::endl;
+        return file;
     }
     
-
-    bool handle_conditional_request(const CORE::Request& req, CORE::Response& res, 
-                                  const std::string& file_path) {
+    // The `coding` variant of `file`, or null if there is none worth
+    // sending. Built once per version of the file and kept in encoded_.
+    std::shared_ptr<const UTILS::CachedFile> find_variant(const std::string& path, const UTILS::CachedFile& file,
+                                                          UTILS::ContentCoding coding, uint64_t generation,
+                                                          LookupStatus& status) {
+        if (bundle_) {
+            return bundle_->find(std::string_view(path).substr(document_root_.size()), coding);
+        }
+        std::string key = path;
+        key += UTILS::coding_suffix(coding);
+        
+        std::shared_ptr<const UTILS::CachedFile> variant;
+        if (encoded_.find(key, file.etag, generation, variant)) {
+            return variant;
+        }
+        
+        // A failure to read the sibling just means serving without it
+        LookupStatus sibling_status;
+        sibling_status.may_block = status.may_block;
+        if (auto sibling = find_file(key, generation, sibling_status)) {
+            variant = make_variant(file, *sibling, sibling->content, coding);
+        } else if (sibling_status.needs_io) {
+            status.needs_io = true;
+            return nullptr;
+        } else if (coding == UTILS::ContentCoding::GZIP && file.content && 
+                   file.file_size >= MIN_COMPRESS_SIZE) {
+            auto compressed = std::make_shared<std::string>();
+            if (UTILS::Gzip::compress(*file.content, *compressed) && compressed->size() < file.file_size) {
+                variant = make_variant(file, file, std::move(compressed), coding);
+            }
+        }
+        
+        encoded_.insert(key, file.etag, generation, variant);
+        return variant;
+    }
+    
+    // An encoded representation: the body and validators of `encoded`,
+    // presented with the type and caching policy of the original. Its ETag
+    // is tagged with the coding so it never matches the identity body's.
+    static std::shared_ptr<const UTILS::CachedFile> make_variant(const UTILS::CachedFile& original,
+                                                                 const UTILS::CachedFile& encoded,
+                                                                 std::shared_ptr<const std::string> content,
+                                                                 UTILS::ContentCoding coding) {
+        auto variant = std::make_shared<UTILS::CachedFile>();
+        variant->content = std::move(content);
+        variant->handle = variant->content ? nullptr : encoded.handle;
+        variant->offset = encoded.offset;
+        variant->file_size = variant->content ? variant->content->size() : encoded.file_size;
+        variant->last_modified = encoded.last_modified;
+        variant->mtime_ns = encoded.mtime_ns;
+        variant->mime_type = original.mime_type;
+        variant->last_modified_text = encoded.last_modified_text;
+        variant->cache_control = original.cache_control;
+        
+        variant->etag = UTILS::variant_etag(encoded.etag, coding);
+        return variant;
+    }
+    
+    // Small files are read once into FileCache and served from memory from
+    // then on; larger ones keep their fd in OpenFileCache and go out with
+    // sendfile() every time
+    std::shared_ptr<const UTILS::CachedFile> load_file(const std::string& path, 
+                                                       const UTILS::FileInfo& file_info,
+                                                       uint64_t generation) {
+        auto file = std::make_shared<UTILS::CachedFile>();
+        file->file_size = file_info.file_size;
+        file->last_modified = file_info.last_modified;
+        file->mime_type = file_info.mime_type;
+        file->last_modified_text = UTILS::FileReader::format_http_date(file_info.last_modified);
+        file->cache_control = UTILS::FileReader::generate_cache_control(file_info.mime_type);
+        
         struct stat file_stat;
-        if (stat(file_path.c_str(), &file_stat) != 0) {
-            return false; // Can't get file info, serve normally
+        if (fstat(file_info.handle->fd(), &file_stat) != 0) {
+            return nullptr;
         }
+        file->mtime_ns = UTILS::FileCache::mtime_ns(file_stat);
+        UTILS::FileVersion version = UTILS::FileVersion::of(file_stat);
+        bool known_etag = etags_.find(path, version, file->etag);
+        UTILS::FileReader::advise_sequential(*file_info.handle, file_info.file_size);
         
-        auto last_modified = std::chrono::system_clock::time_point(
-            std::chrono::seconds(file_stat.st_mtime));
-        std::string current_etag = UTILS::FileReader::generate_etag(
-            file_stat.st_size, last_modified);
+        if (file_info.file_size > UTILS::FileCache::MAX_ENTRY_SIZE) {
+            uint64_t hash;
+            if (!known_etag) {
+                if (!UTILS::FileReader::hash_contents(*file_info.handle, file_info.file_size, hash)) {
+                    return nullptr;
+                }
+                file->etag = UTILS::FileReader::generate_etag(hash);
+                etags_.insert(path, version, file->etag);
+            }
+            file->handle = file_info.handle;
+            open_files_.insert(path, file, generation);
+            return file;
+        }
         
-        auto if_none_match = req.headers.find("if-none-match");
-        if (if_none_match != req.headers.end()) {
-            std::string client_etag = UTILS::StringUtils::trim(if_none_match->second);
-            
-            if (client_etag == current_etag) {
+        auto content = std::make_shared<std::string>();
+        if (!UTILS::FileReader::read_contents(*file_info.handle, file_info.file_size, *content)) {
+            return nullptr;
+        }
+        if (!known_etag) {
+            file->etag = UTILS::FileReader::generate_etag(UTILS::XXHash64::hash(*content));
+            etags_.insert(path, version, file->etag);
+        }
+        file->content = std::move(content);
+        file_cache_.insert(path, file, generation);
+        return file;
+    }
+    
+    // Everything below works from the cached metadata; the body is either
+    // the shared in-memory copy or a slice of the cached fd
+    void serve_cached(const CORE::Request& req, CORE::Response& res, const UTILS::CachedFile& file) {
+        set_file_headers(res, file.mime_type, file.etag, file.last_modified_text, file.cache_control);
+        
+        switch (evaluate_preconditions(req, file)) {
+            case 304:
                 res.status_code = 304;
                 res.status_text = "Not Modified";
-                res.headers["ETag"] = current_etag;
-                res.headers["Last-Modified"] = UTILS::FileReader::format_http_date(last_modified);
-                res.headers["Cache-Control"] = UTILS::FileReader::generate_cache_control(
-                    UTILS::MimeTypeDetector::get_mime_type(file_path));
-                
-                std::cout << "💾 304 Not Modified: " << file_path << std::endl;
-                return true; // We handled the request
+                return;
+            case 412:
+                res.status_code = 412;
+                res.status_text = "Precondition Failed";
+                res.headers.set(CORE::HeaderId::CONTENT_LENGTH, "0");
+                return;
+        }
+        
+        BodySource source{file.handle, file.offset, file.content};
+        if (respond_to_range(req, res, source, file.mime_type, file.file_size, 
+                             file.etag, file.last_modified_text)) {
+            return;
+        }
+        
+        res.status_code = 200;
+        res.status_text = "OK";
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, file.mime_type);
+        if (file.content) {
+            res.shared_body = file.content;
+        } else {
+            res.file_body = UTILS::FileSlice{file.handle, file.offset, file.file_size};
+        }
+        res.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(res.content_length()));
+    }
+    
+    // Conditional headers in the order RFC 9110 13.2.2 gives: If-Match,
+    // else If-Unmodified-Since; then If-None-Match, else If-Modified-Since.
+    // Returns 412 or 304 to answer with, or 0 to serve the request.
+    static int evaluate_preconditions(const CORE::Request& req, const UTILS::CachedFile& file) {
+        std::time_t modified = std::chrono::system_clock::to_time_t(file.last_modified);
+        std::time_t since;
+        
+        std::string_view if_match = req.headers.get(CORE::HeaderId::IF_MATCH);
+        if (!if_match.empty()) {
+            if (!etag_list_matches(if_match, file.etag, false)) return 412;
+        } else {
+            std::string_view if_unmodified = req.headers.get(CORE::HeaderId::IF_UNMODIFIED_SINCE);
+            if (!if_unmodified.empty() && UTILS::parse_http_date(if_unmodified, since) && modified > since) {
+                return 412;
+            }
+        }
+        
+        std::string_view if_none_match = req.headers.get(CORE::HeaderId::IF_NONE_MATCH);
+        if (!if_none_match.empty()) {
+            return etag_list_matches(if_none_match, file.etag, true) ? 304 : 0;
+        }
+        
+        // A date in the future is invalid and ignored
+        std::string_view if_modified = req.headers.get(CORE::HeaderId::IF_MODIFIED_SINCE);
+        if (!if_modified.empty() && UTILS::parse_http_date(if_modified, since) &&
+            since <= std::time(nullptr) && modified <= since) {
+            return 304;
+        }
+        return 0;
+    }
+    
+    // Does a comma-separated list of entity tags (or "*") name `etag`?
+    // Weak comparison ignores the W/ prefix; strong comparison never
+    // matches a weak tag. A malformed list matches nothing.
+    static bool etag_list_matches(std::string_view list, std::string_view etag, bool weak_comparison) {
+        size_t i = 0;
+        auto skip_separators = [&] {
+            while (i < list.size() && (list[i] == ' ' || list[i] == '\t' || list[i] == ',')) ++i;
+        };
+        
+        skip_separators();
+        if (list.substr(i) == "*") return true;
+        
+        while (i < list.size()) {
+            bool weak = false;
+            if (list.compare(i, 2, "W/") == 0) {
+                weak = true;
+                i += 2;
             }
+            if (i >= list.size() || list[i] != '"') return false;
+            size_t close = list.find('"', i + 1);
+            if (close == std::string_view::npos) return false;
+            
+            std::string_view tag = list.substr(i, close - i + 1);
+            if (tag == etag && (weak_comparison || !weak)) return true;
+            i = close + 1;
+            skip_separators();
         }
+        return false;
+    }
+    
+    void set_file_headers(CORE::Response& res, std::string_view mime_type, std::string_view etag,
+                          std::string_view last_modified, std::string_view cache_control) {
+        res.headers.set(CORE::HeaderId::SERVER, CORE::SERVER_NAME);
+        res.headers.set(CORE::HeaderId::LAST_MODIFIED, last_modified);
+        res.headers.set(CORE::HeaderId::ETAG, etag);
+        res.headers.set(CORE::HeaderId::CACHE_CONTROL, cache_control);
+        res.headers.set(CORE::HeaderId::ACCEPT_RANGES, "bytes");
         
-        return false; // File needs to be sent normally
+        if (UTILS::StringUtils::starts_with(mime_type, "text/html")) {
+            res.headers.set("X-Content-Type-Options", "nosniff");
+        }
+    }
+    
+    // Where range bodies come from: an open file (sent with sendfile) from
+    // `offset` on, or a cached copy in memory
+    struct BodySource {
+        std::shared_ptr<const UTILS::FileHandle> file;
+        uint64_t offset;
+        std::shared_ptr<const std::string> memory;
+        
+        void append(CORE::BodySegment& segment, const UTILS::ByteRange& range) const {
+            if (file) {
+                segment.file = UTILS::FileSlice{file, offset + range.first, range.length()};
+            } else {
+                segment.text.append(*memory, range.first, range.length());
+            }
+        }
+    };
+    
+    // Answers Range requests (206/416); returns false if the full body
+    // should be sent. Range is honoured only while If-Range (if sent) still
+    // names this version.
+    bool respond_to_range(const CORE::Request& req, CORE::Response& res, const BodySource& source,
+                          std::string_view mime_type, size_t file_size,
+                          std::string_view etag, std::string_view last_modified) {
+        if (!req.headers.contains(CORE::HeaderId::RANGE) || !if_range_matches(req, etag, last_modified)) {
+            return false;
+        }
+        
+        std::vector<UTILS::ByteRange> ranges;
+        auto result = UTILS::RangeParser::parse(req.headers.get(CORE::HeaderId::RANGE), file_size, ranges);
+        if (result == UTILS::RangeResult::IGNORE) {
+            return false;
+        }
+        
+        if (result == UTILS::RangeResult::UNSATISFIABLE) {
+            res.status_code = 416;
+            res.status_text = "Range Not Satisfiable";
+            res.headers.set(CORE::HeaderId::CONTENT_RANGE, "bytes */" + std::to_string(file_size));
+            res.headers.set(CORE::HeaderId::CONTENT_LENGTH, "0");
+            return true;
+        }
+        
+        send_ranges(res, source, mime_type, file_size, ranges);
+        return true;
+    }
+    
+    // 206 with one range as a plain body, or several as multipart/byteranges
+    void send_ranges(CORE::Response& res, const BodySource& source, std::string_view mime_type,
+                     size_t file_size, const std::vector<UTILS::ByteRange>& ranges) {
+        res.status_code = 206;
+        res.status_text = "Partial Content";
+        std::string total = "/" + std::to_string(file_size);
+        
+        if (ranges.size() == 1) {
+            const auto& range = ranges.front();
+            res.headers.set(CORE::HeaderId::CONTENT_TYPE, mime_type);
+            res.headers.set(CORE::HeaderId::CONTENT_RANGE, "bytes " + std::to_string(range.first) + 
+                            "-" + std::to_string(range.last) + total);
+            res.body_segments.emplace_back();
+            source.append(res.body_segments.back(), range);
+            res.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(res.content_length()));
+            return;
+        }
+        
+        std::string boundary = generate_boundary();
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, "multipart/byteranges; boundary=" + boundary);
+        
+        res.body_segments.reserve(ranges.size() + 1);
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            const auto& range = ranges[i];
+            CORE::BodySegment part;
+            if (i > 0) part.text += "\r\n";
+            part.text += "--" + boundary + "\r\n";
+            part.text += "Content-Type: ";
+            part.text += mime_type;
+            part.text += "\r\nContent-Range: bytes " + std::to_string(range.first) + "-" + 
+                         std::to_string(range.last) + total + "\r\n\r\n";
+            source.append(part, range);
+            res.body_segments.push_back(std::move(part));
+        }
+        res.body_segments.push_back(CORE::BodySegment{"\r\n--" + boundary + "--\r\n", {}});
+        res.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(res.content_length()));
+    }
+    
+    // If-Range carries either an ETag, compared strongly (weak tags never
+    // match), or the exact Last-Modified date we would send
+    static bool if_range_matches(const CORE::Request& req, std::string_view etag, 
+                                 std::string_view last_modified) {
+        std::string_view if_range = req.headers.get(CORE::HeaderId::IF_RANGE);
+        if (if_range.empty()) return true;
+        if (if_range.front() == '"') return if_range == etag;
+        if (if_range.size() > 1 && if_range[0] == 'W' && if_range[1] == '/') return false;
+        return if_range == last_modified;
+    }
+    
+    static std::string generate_boundary() {
+        static constexpr char HEX[] = "0123456789abcdef";
+        thread_local std::mt19937_64 generator{std::random_device{}()};
+        uint64_t value = generator();
+        std::string boundary = "see-plus-plus-";
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            boundary += HEX[(value >> shift) & 0xF];
+        }
+        return boundary;
     }
     
 
@@ -132,8 +626,8 @@ private:
                                const std::string& dir_path) {
         res.status_code = 200;
         res.status_text = "OK";
-        res.headers["Content-Type"] = "text/html";
-        res.headers["Server"] = "see-plus-plus/1.0";
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, "text/html");
+        res.headers.set(CORE::HeaderId::SERVER, CORE::SERVER_NAME);
         
         res.body = R"(<!DOCTYPE html>
 <html>
@@ -153,18 +647,39 @@ private:
 </body>
 </html>)";
         
-        res.headers["Content-Length"] = std::to_string(res.body.size());
+        res.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(res.body.size()));
     }
     
 
+    // 403 and 404 pages never change, so they are rendered once and
+    // shared by every response that carries them
+    void send_error_response(CORE::Response& res, int status_code) {
+        static const auto forbidden_page = std::make_shared<const std::string>(render_error_page(
+            403, "Forbidden", "Access to the requested path is not allowed"));
+        static const auto not_found_page = std::make_shared<const std::string>(render_error_page(
+            404, "Not Found", "The requested file could not be found"));
+        
+        res.status_code = status_code;
+        res.status_text = std::string(CORE::reason_phrase(status_code));
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, "text/html");
+        res.headers.set(CORE::HeaderId::SERVER, CORE::SERVER_NAME);
+        res.shared_body = status_code == 403 ? forbidden_page : not_found_page;
+        res.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(res.shared_body->size()));
+    }
+    
     void send_error_response(CORE::Response& res, int status_code, 
                            const std::string& status_text, const std::string& message) {
         res.status_code = status_code;
         res.status_text = status_text;
-        res.headers["Content-Type"] = "text/html";
-        res.headers["Server"] = "see-plus-plus/1.0";
-        
-        res.body = R"(<!DOCTYPE html>
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, "text/html");
+        res.headers.set(CORE::HeaderId::SERVER, CORE::SERVER_NAME);
+        res.body = render_error_page(status_code, status_text, message);
+        res.headers.set(CORE::HeaderId::CONTENT_LENGTH, std::to_string(res.body.size()));
+    }
+    
+    static std::string render_error_page(int status_code, const std::string& status_text, 
+                                         const std::string& message) {
+        return R"(<!DOCTYPE html>
 <html>
 <head>
     <title>)" + std::to_string(status_code) + " " + status_text + R"(</title>
@@ -186,7 +701,5 @@ private:
     </div>
 </body>
 </html>)";
-        
-        res.headers["Content-Length"] = std::to_string(res.body.size());
     }
 };
\ No newline at end of file
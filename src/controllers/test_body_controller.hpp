@@ -7,7 +7,7 @@ public:
     void handle(const CORE::Request& req, CORE::Response& res) override {
         res.status_code = 200;
         res.status_text = "OK";
-        res.headers["Content-Type"] = "application/json";
+        res.headers.set("Content-Type", "application/json");
         
         // Build JSON response showing what we parsed
         std::ostringstream json;
@@ -25,11 +25,14 @@ public:
         
         // Show parsed content based on type
         if (req.parsed_body.type == CORE::BodyType::JSON) {
-            json << "  \"json_content\": \"" << escape_json(req.parsed_body.json_string) << "\",\n";
+            json << "  \"json_content\": \"" << escape_json(req.body) << "\",\n";
+            const CORE::JsonValue& root = req.json();
+            json << "  \"json_root_type\": \"" << json_type_to_string(root.type()) << "\",\n";
+            json << "  \"json_root_size\": " << root.size() << ",\n";
         } else if (req.parsed_body.type == CORE::BodyType::FORM_URLENCODED) {
             json << "  \"form_data\": {\n";
             bool first = true;
-            for (const auto& [key, value] : req.parsed_body.form_data) {
+            for (const auto& [key, value] : req.form_data()) {
                 if (!first) json << ",\n";
                 json << "    \"" << escape_json(key) << "\": \"" << escape_json(value) << "\"";
                 first = false;
@@ -39,23 +42,17 @@ public:
         
         // Show some headers
         json << "  \"content_type\": \"";
-        auto ct = req.headers.find("content-type");
-        if (ct != req.headers.end()) {
-            json << escape_json(ct->second);
-        }
+        json << escape_json(std::string(req.headers.get("content-type")));
         json << "\",\n";
         
         json << "  \"content_length\": \"";
-        auto cl = req.headers.find("content-length");
-        if (cl != req.headers.end()) {
-            json << cl->second;
-        }
+        json << req.headers.get("content-length");
         json << "\"\n";
         
         json << "}";
         
         res.body = json.str();
-        res.headers["Content-Length"] = std::to_string(res.body.size());
+        res.headers.set("Content-Length", std::to_string(res.body.size()));
     }
     
 private:
@@ -70,6 +67,18 @@ private:
         }
     }
     
+    std::string json_type_to_string(CORE::JsonType type) {
+        switch (type) {
+            case CORE::JsonType::NULL_VALUE: return "null";
+            case CORE::JsonType::BOOLEAN: return "boolean";
+            case CORE::JsonType::NUMBER: return "number";
+            case CORE::JsonType::STRING: return "string";
+            case CORE::JsonType::ARRAY: return "array";
+            case CORE::JsonType::OBJECT: return "object";
+            default: return "unknown";
+        }
+    }
+    
     std::string escape_json(const std::string& str) {
         std::string escaped;
         for (char c : str) {
@@ -97,6 +97,16 @@ namespace CORE {
             return it->second->total_bytes_received <= MAX_REQUEST_SIZE;
         }
         
+        // Would another `additional_bytes` still fit in the request size
+        // limit? Unlike check_request_size_limit this does not count them.
+        bool can_receive(int fd, size_t additional_bytes) const {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) return false;
+            
+            return it->second->total_bytes_received + additional_bytes <= MAX_REQUEST_SIZE;
+        }
+        
         void reset_parser(int fd) {
             std::unique_lock<std::shared_mutex> lock(mutex_);
             auto it = connections_.find(fd);
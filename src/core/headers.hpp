@@ -0,0 +1,286 @@
+#pragma once
+
+#include "../utils/perfect_hash.hpp"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace CORE {
+
+    // Well-known header names get a fixed slot so the hot lookups
+    // (connection, content-length, content-type, ...) are an array read
+    // instead of a string hash. Anything else is stored as UNKNOWN.
+    enum class HeaderId : uint8_t {
+        ACCEPT,
+        ACCEPT_ENCODING,
+        ACCEPT_RANGES,
+        CACHE_CONTROL,
+        CONNECTION,
+        CONTENT_ENCODING,
+        CONTENT_LENGTH,
+        CONTENT_RANGE,
+        CONTENT_TYPE,
+        DATE,
+        ETAG,
+        EXPECT,
+        HOST,
+        IF_MATCH,
+        IF_MODIFIED_SINCE,
+        IF_NONE_MATCH,
+        IF_RANGE,
+        IF_UNMODIFIED_SINCE,
+        LAST_MODIFIED,
+        RANGE,
+        SERVER,
+        TRANSFER_ENCODING,
+        USER_AGENT,
+        VARY,
+        UNKNOWN
+    };
+
+    static constexpr size_t KNOWN_HEADER_COUNT = static_cast<size_t>(HeaderId::UNKNOWN);
+
+    using UTILS::iequals;
+
+    // Canonical spelling of each well-known header, indexed by HeaderId
+    static constexpr std::array<std::string_view, KNOWN_HEADER_COUNT> KNOWN_HEADER_NAMES = {
+        "Accept",
+        "Accept-Encoding",
+        "Accept-Ranges",
+        "Cache-Control",
+        "Connection",
+        "Content-Encoding",
+        "Content-Length",
+        "Content-Range",
+        "Content-Type",
+        "Date",
+        "ETag",
+        "Expect",
+        "Host",
+        "If-Match",
+        "If-Modified-Since",
+        "If-None-Match",
+        "If-Range",
+        "If-Unmodified-Since",
+        "Last-Modified",
+        "Range",
+        "Server",
+        "Transfer-Encoding",
+        "User-Agent",
+        "Vary"
+    };
+
+    inline constexpr UTILS::PerfectHashMap<KNOWN_HEADER_COUNT, 128> KNOWN_HEADER_TABLE {KNOWN_HEADER_NAMES};
+
+    // Case-insensitive name -> HeaderId, one hash probe and no allocation
+    constexpr HeaderId lookup_header_id(std::string_view name) {
+        return static_cast<HeaderId>(KNOWN_HEADER_TABLE.find(name));
+    }
+
+    // Headers is a flat, insertion-ordered header container. Names and values
+    // live in a single byte buffer and entries are offsets into it, so adding
+    // a header never allocates a node. The parser hands over the raw header
+    // block with adopt() and then registers views into it without copying.
+    //
+    // Lookups are case-insensitive. Well-known headers resolve through a slot
+    // table in O(1); other names fall back to a linear scan, which is cheap
+    // for the handful of headers a request usually carries.
+    class Headers {
+    public:
+        static constexpr size_t INLINE_CAPACITY = 16;
+
+        struct Field {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        class const_iterator {
+        public:
+            const_iterator(const Headers* owner, size_t index) : owner_(owner), index_(index) {}
+
+            Field operator*() const { return owner_->field(index_); }
+            const_iterator& operator++() { ++index_; return *this; }
+            bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+            bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+        private:
+            const Headers* owner_;
+            size_t index_;
+        };
+
+        // Take ownership of a raw header block; returns a view the caller
+        // can slice into and pass back to add() without any copies
+        std::string_view adopt(std::string block) {
+            clear();
+            storage_ = std::move(block);
+            return std::string_view(storage_);
+        }
+
+        // Append a header, keeping earlier ones with the same name.
+        // Lookups return the most recently added value.
+        void add(std::string_view name, std::string_view value) {
+            add(lookup_header_id(name), name, value);
+        }
+
+        void add(HeaderId id, std::string_view name, std::string_view value) {
+            Entry entry;
+            entry.id = id;
+            place(name, value, entry);
+            push(entry);
+        }
+
+        // Set a header, replacing the latest existing value with the same name
+        void set(std::string_view name, std::string_view value) {
+            set(lookup_header_id(name), name, value);
+        }
+
+        void set(HeaderId id, std::string_view value) {
+            set(id, KNOWN_HEADER_NAMES[static_cast<size_t>(id)], value);
+        }
+
+        std::string_view get(HeaderId id) const {
+            if (id == HeaderId::UNKNOWN) return {};
+            uint16_t slot = slots_[static_cast<size_t>(id)];
+            return slot ? view(entry(slot - 1).value_off, entry(slot - 1).value_len)
+                        : std::string_view{};
+        }
+
+        std::string_view get(std::string_view name) const {
+            size_t index = find_index(lookup_header_id(name), name);
+            return index != npos ? view(entry(index).value_off, entry(index).value_len)
+                                 : std::string_view{};
+        }
+
+        bool contains(HeaderId id) const {
+            return id != HeaderId::UNKNOWN && slots_[static_cast<size_t>(id)] != 0;
+        }
+
+        bool contains(std::string_view name) const {
+            return find_index(lookup_header_id(name), name) != npos;
+        }
+
+        size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+
+        // Size the name/value buffer up front so building a header block
+        // does not reallocate it as it grows
+        void reserve(size_t bytes) { storage_.reserve(bytes); }
+
+        // Drop all headers but keep the buffers around for reuse
+        void clear() {
+            storage_.clear();
+            overflow_.clear();
+            slots_.fill(0);
+            count_ = 0;
+        }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, count_); }
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        struct Entry {
+            uint32_t name_off = 0;
+            uint32_t value_off = 0;
+            uint32_t value_len = 0;
+            uint16_t name_len = 0;
+            HeaderId id = HeaderId::UNKNOWN;
+        };
+
+        std::string storage_;
+        std::array<Entry, INLINE_CAPACITY> inline_ {};
+        std::vector<Entry> overflow_;
+        std::array<uint16_t, KNOWN_HEADER_COUNT> slots_ {};  // entry index + 1, 0 = absent
+        size_t count_ = 0;
+
+        const Entry& entry(size_t index) const {
+            return index < INLINE_CAPACITY ? inline_[index] : overflow_[index - INLINE_CAPACITY];
+        }
+
+        Entry& entry(size_t index) {
+            return index < INLINE_CAPACITY ? inline_[index] : overflow_[index - INLINE_CAPACITY];
+        }
+
+        std::string_view view(uint32_t offset, uint32_t length) const {
+            return std::string_view(storage_).substr(offset, length);
+        }
+
+        Field field(size_t index) const {
+            const Entry& e = entry(index);
+            return Field{view(e.name_off, e.name_len), view(e.value_off, e.value_len)};
+        }
+
+        bool owns(std::string_view sv) const {
+            const char* begin = storage_.data();
+            return !sv.empty() && sv.data() >= begin && sv.data() + sv.size() <= begin + storage_.size();
+        }
+
+        // Record where name/value live, copying them into storage only when
+        // they are not already views into it. Offsets are taken before any
+        // append so a reallocation cannot invalidate them.
+        void place(std::string_view name, std::string_view value, Entry& e) {
+            bool name_inside = owns(name);
+            bool value_inside = owns(value);
+            if (name_inside) e.name_off = static_cast<uint32_t>(name.data() - storage_.data());
+            if (value_inside) e.value_off = static_cast<uint32_t>(value.data() - storage_.data());
+
+            if (!name_inside) {
+                e.name_off = static_cast<uint32_t>(storage_.size());
+                storage_.append(name);
+            }
+            if (!value_inside) {
+                e.value_off = static_cast<uint32_t>(storage_.size());
+                storage_.append(value);
+            }
+            e.name_len = static_cast<uint16_t>(name.size());
+            e.value_len = static_cast<uint32_t>(value.size());
+        }
+
+        void push(const Entry& e) {
+            if (count_ < INLINE_CAPACITY) {
+                inline_[count_] = e;
+            } else {
+                overflow_.push_back(e);
+            }
+            ++count_;
+            if (e.id != HeaderId::UNKNOWN) {
+                slots_[static_cast<size_t>(e.id)] = static_cast<uint16_t>(count_);
+            }
+        }
+
+        void set(HeaderId id, std::string_view name, std::string_view value) {
+            size_t index = find_index(id, name);
+            if (index == npos) {
+                add(id, name, value);
+                return;
+            }
+            Entry& e = entry(index);
+            if (owns(value)) {
+                e.value_off = static_cast<uint32_t>(value.data() - storage_.data());
+            } else {
+                e.value_off = static_cast<uint32_t>(storage_.size());
+                storage_.append(value);
+            }
+            e.value_len = static_cast<uint32_t>(value.size());
+        }
+
+        size_t find_index(HeaderId id, std::string_view name) const {
+            if (id != HeaderId::UNKNOWN) {
+                uint16_t slot = slots_[static_cast<size_t>(id)];
+                return slot ? slot - 1 : npos;
+            }
+            for (size_t i = count_; i-- > 0;) {
+                const Entry& e = entry(i);
+                if (e.id == HeaderId::UNKNOWN && iequals(view(e.name_off, e.name_len), name)) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+    };
+
+} // namespace CORE
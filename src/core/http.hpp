@@ -1,12 +1,54 @@
 #pragma once 
 
+#include "headers.hpp"
+#include "json.hpp"
+#include "prebuilt_responses.hpp"
+#include "../utils/perfect_hash.hpp"
+#include "../utils/file_handle.hpp"
+#include "../utils/string_utils.hpp"
+#include <array>
+#include <chrono>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
-#include <sstream>
+#include <charconv>
+#include <functional>
 
 namespace CORE {
 
+    // HTTP request methods. Method names are case-sensitive (RFC 9110),
+    // so unlike header names they are matched exactly.
+    enum class Method : uint8_t {
+        GET,
+        POST,
+        PUT,
+        DELETE,
+        HEAD,
+        OPTIONS,
+        PATCH,
+        TRACE,
+        CONNECT,
+        UNKNOWN
+    };
+
+    static constexpr size_t METHOD_COUNT = static_cast<size_t>(Method::UNKNOWN);
+
+    static constexpr std::array<std::string_view, METHOD_COUNT> METHOD_NAMES = {
+        "GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH", "TRACE", "CONNECT"
+    };
+
+    inline constexpr UTILS::PerfectHashMap<METHOD_COUNT, 32, false> METHOD_TABLE {METHOD_NAMES};
+
+    constexpr Method parse_method(std::string_view name) {
+        return static_cast<Method>(METHOD_TABLE.find(name));
+    }
+
+    constexpr std::string_view method_name(Method method) {
+        return method == Method::UNKNOWN ? std::string_view{} : METHOD_NAMES[static_cast<size_t>(method)];
+    }
+
     enum class BodyType {
         NONE,
         JSON,
@@ -15,15 +57,15 @@ namespace CORE {
         RAW
     };
 
+    using FormData = std::unordered_map<std::string, std::string>;
+
+    // ParsedBody records what the parser learned about Request::body without
+    // copying it. Form fields are decoded on first access through
+    // Request::form_data(); the JSON DOM is built by the parser in the same
+    // pass that validates it. The caches own their data, so copies of the
+    // Request can share them.
     struct ParsedBody {
         BodyType type = BodyType::NONE;
-        std::string raw_content;
-        
-        // For JSON
-        std::string json_string;
-        
-        // For form data (both URL-encoded and multipart)
-        std::unordered_map<std::string, std::string> form_data;
         
         // For multipart files
         struct FileUpload {
@@ -36,17 +78,109 @@ namespace CORE {
         
         bool success = false;
         std::string error_message;
+
+        // Lazily materialized, a request is only ever handled by one worker
+        mutable std::shared_ptr<const FormData> form_cache;
+        mutable std::shared_ptr<const JsonDocument> json_cache;
+
+        static FormData decode_form_urlencoded(std::string_view body) {
+            FormData form;
+            while (!body.empty()) {
+                size_t amp_pos = body.find('&');
+                std::string_view pair = body.substr(0, amp_pos);
+                body = amp_pos == std::string_view::npos ? std::string_view{} : body.substr(amp_pos + 1);
+
+                size_t eq_pos = pair.find('=');
+                if (eq_pos != std::string_view::npos) {
+                    std::string name;
+                    std::string value;
+                    UTILS::StringUtils::append_url_decoded(pair.substr(0, eq_pos), name, true);
+                    UTILS::StringUtils::append_url_decoded(pair.substr(eq_pos + 1), value, true);
+                    form[std::move(name)] = std::move(value);
+                }
+            }
+            return form;
+        }
+    };
+
+    // Captures from the matched route pattern (":id", "*rest"). Values are
+    // kept as offsets into Request::path, so they stay valid when the
+    // Request is moved; names point into the Router, which outlives it.
+    struct RouteParams {
+        static constexpr size_t MAX_PARAMS = 8;
+
+        struct Param {
+            std::string_view name;
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        Param items[MAX_PARAMS];
+        size_t count = 0;
+
+        void add(std::string_view name, size_t offset, size_t length) {
+            items[count++] = Param{name, static_cast<uint32_t>(offset), static_cast<uint32_t>(length)};
+        }
     };
 
     // Request represents a HTTP request being sent to 
     // our server over some transport protocol (TCP, UDP)
     struct Request {
         std::string method {};
+        Method method_id = Method::UNKNOWN;
         std::string path {};
         std::string version {};
-        std::unordered_map<std::string, std::string> headers {};
-        std::string body {};  // Raw body content
-        ParsedBody parsed_body {}; // Parsed body based on Content-Type
+        Headers headers {};
+        std::string body {};  // Raw body content, the only copy of it
+        ParsedBody parsed_body {}; // What kind of body it is, decoded on demand
+
+        RouteParams route_params {};
+        std::chrono::steady_clock::time_point started {}; // When a worker took it up
+
+        // A captured path parameter, or empty if the route has none by that
+        // name. The value is still percent-encoded, as it appears in the path.
+        std::string_view param(std::string_view name) const {
+            for (size_t i = 0; i < route_params.count; ++i) {
+                const auto& item = route_params.items[i];
+                if (item.name == name) {
+                    return std::string_view(path).substr(item.offset, item.length);
+                }
+            }
+            return {};
+        }
+
+        // URL-encoded form fields, decoded on first call
+        const FormData& form_data() const {
+            if (!parsed_body.form_cache) {
+                parsed_body.form_cache = std::make_shared<const FormData>(
+                    parsed_body.type == BodyType::FORM_URLENCODED
+                        ? ParsedBody::decode_form_urlencoded(body) : FormData{});
+            }
+            return *parsed_body.form_cache;
+        }
+
+        // JSON DOM root, as built by the parser, or null for a non-JSON
+        // body. A Request that did not come through the parser has its
+        // body parsed on first call instead.
+        const JsonValue& json() const {
+            if (parsed_body.type != BodyType::JSON) {
+                return JsonValue::null_value();
+            }
+            if (!parsed_body.json_cache) {
+                auto document = std::make_shared<JsonDocument>();
+                document->parse(body);
+                parsed_body.json_cache = std::move(document);
+            }
+            return parsed_body.json_cache->root();
+        }
+    };
+
+    // One piece of a segmented body: literal bytes, then a file range.
+    // multipart/byteranges bodies interleave part headers with file ranges
+    // this way, so every range still goes out with sendfile().
+    struct BodySegment {
+        std::string text;
+        UTILS::FileSlice file;
     };
 
     // Response represents a HTTP Response being sent out
@@ -54,17 +188,103 @@ namespace CORE {
     struct Response {
         uint16_t status_code {};
         std::string status_text {};
-        std::unordered_map<std::string, std::string> headers {};
+        Headers headers {};
         std::string body {};
+        
+        // Immutable body shared with a cache; when set it is sent in place
+        // of `body` without being copied into the response
+        std::shared_ptr<const std::string> shared_body {};
+        
+        // When set, this file range is the body instead of `body`, and the
+        // send path hands it to sendfile() without reading it into memory
+        UTILS::FileSlice file_body {};
+        
+        // When non-empty, the body is these segments in order, and both
+        // `body` and `file_body` are ignored
+        std::vector<BodySegment> body_segments {};
+        
+        // Set by a handler that cannot answer without blocking file I/O
+        // (a cache miss on a cold file). The request task then hands the
+        // request to the I/O executor, which runs this to finish the
+        // response and sends it from there, so request workers never
+        // wait on the disk. Leave empty to answer right away.
+        std::function<void(const Request&, Response&)> io_work {};
 
+        size_t content_length() const {
+            if (!body_segments.empty()) {
+                size_t total = 0;
+                for (const auto& segment : body_segments) {
+                    total += segment.text.size();
+                    if (segment.file) total += static_cast<size_t>(segment.file.length);
+                }
+                return total;
+            }
+            return file_body ? static_cast<size_t>(file_body.length) : memory_body().size();
+        }
+        
+        // The in-memory body: shared_body if set, otherwise body
+        std::string_view memory_body() const {
+            return shared_body ? std::string_view(*shared_body) : std::string_view(body);
+        }
+
+        // Append the status line and headers, including the blank line that
+        // ends them, to `out`. The body is left alone so it can be sent from
+        // where it already lives (see ResponseWriter).
+        void serialize_head(std::string& out) const {
+            std::string_view prebuilt = status_line(status_code);
+            if (!prebuilt.empty() && status_text == reason_phrase(status_code)) {
+                out.append(prebuilt);
+            } else {
+                char code[8];
+                auto [code_end, ec] = std::to_chars(code, code + sizeof(code), status_code);
+                (void)ec;
+                out.append("HTTP/1.1 ", 9);
+                out.append(code, code_end - code);
+                out.push_back(' ');
+                out.append(status_text);
+                out.append("\r\n", 2);
+            }
+            for (Headers::Field field : headers) {
+                out.append(field.name);
+                out.append(": ", 2);
+                out.append(field.value);
+                out.append("\r\n", 2);
+            }
+            out.append("\r\n", 2);
+        }
+
+        // Whole response as one string. Copies the body (reading it in if
+        // it is file-backed); the send path uses serialize_head() plus the
+        // body in place instead.
         std::string str() const {
-            std::ostringstream oss;
-            oss << "HTTP/1.1 " << status_code << " " << status_text << "\r\n";
-            for (auto& [k,v]: headers) {
-                oss << k << ": " << v << "\r\n";
+            std::string out;
+            out.reserve(256 + content_length());
+            serialize_head(out);
+            if (!body_segments.empty()) {
+                for (const auto& segment : body_segments) {
+                    out.append(segment.text);
+                    if (segment.file) append_file(out, segment.file);
+                }
+            } else if (file_body) {
+                append_file(out, file_body);
+            } else {
+                out.append(memory_body());
+            }
+            return out;
+        }
+
+    private:
+        static void append_file(std::string& out, const UTILS::FileSlice& slice) {
+            size_t start = out.size();
+            out.resize(start + slice.length);
+            size_t done = 0;
+            while (done < slice.length) {
+                ssize_t n = pread(slice.file->fd(), &out[start + done],
+                                  slice.length - done, slice.offset + done);
+                if (n <= 0) break;
+                done += static_cast<size_t>(n);
             }
-            oss << "\r\n" << body;
-            return oss.str();
+            out.resize(start + done);
         }
     };
 } // namespace CORE
\ No newline at end of file
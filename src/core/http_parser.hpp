@@ -4,6 +4,7 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <charconv>
 #include <string_view>
 #include <vector>
 
@@ -26,7 +27,8 @@ namespace CORE {
         INVALID_CONTENT_LENGTH,
         MALFORMED_DATA,
         TOO_MANY_HEADERS,
-        INVALID_BODY_FORMAT
+        INVALID_BODY_FORMAT,
+        EXPECTATION_FAILED
     };
 
     class HTTPParser {
@@ -40,6 +42,8 @@ namespace CORE {
         
         HTTPParser() = default;
         
+        // Feed received bytes. The request is assembled inside the parser
+        // across calls and moved into `request` once it is complete.
         bool parse(const std::string& data, Request& request) {
             if (buffer.size() + data.size() > MAX_BUFFER_SIZE) {
                 state = ParseState::ERROR;
@@ -58,16 +62,16 @@ namespace CORE {
                 
                 switch (state) {
                     case ParseState::PARSING_REQUEST_LINE:
-                        made_progress = parse_request_line(request);
+                        made_progress = parse_request_line(pending);
                         break;
                     case ParseState::PARSING_HEADERS:
-                        made_progress = parse_headers(request);
+                        made_progress = parse_headers(pending);
                         break;
                     case ParseState::PARSING_BODY:
-                        made_progress = parse_body(request);
+                        made_progress = parse_body(pending);
                         break;
                     case ParseState::PARSING_BODY_CONTENT:
-                        made_progress = parse_body_content(request);
+                        made_progress = parse_body_content(pending);
                         break;
                     default:
                         break;
@@ -83,13 +87,48 @@ namespace CORE {
                 return false;
             }
             
-            return state == ParseState::COMPLETE;
+            if (state != ParseState::COMPLETE) {
+                return false;
+            }
+            request = std::move(pending);
+            pending = Request();
+            return true;
         }
         
         bool is_complete() const { return state == ParseState::COMPLETE; }
         bool has_error() const { return state == ParseState::ERROR; }
         ParseError get_error() const { return error; }
         
+        // Status code the reactor should answer a parse error with
+        int get_error_status() const {
+            switch (error) {
+                case ParseError::BUFFER_TOO_LARGE: return 413;
+                case ParseError::EXPECTATION_FAILED: return 417;
+                default: return 400;
+            }
+        }
+        
+        // True exactly once per request, when the headers are in and a body
+        // is still outstanding. The reactor uses it to accept or reject the
+        // body before it is transferred (size limits, Expect: 100-continue).
+        bool awaiting_body_decision() const {
+            return state == ParseState::PARSING_BODY && !body_decided;
+        }
+        void mark_body_decided() { body_decided = true; }
+        
+        // The client sent Expect: 100-continue and waits for our go-ahead
+        bool expects_continue() const { return expect_continue; }
+        
+        // Body bytes still to come for the request being parsed
+        size_t remaining_body_bytes() const {
+            if (state != ParseState::PARSING_BODY) return 0;
+            size_t buffered = buffer.size() - headers_end_pos;
+            return buffered < content_length ? content_length - buffered : 0;
+        }
+        
+        // Request line and headers of the request being parsed
+        const Request& pending_request() const { return pending; }
+        
         std::string get_error_description() const {
             switch (error) {
                 case ParseError::NONE: return "No error";
@@ -100,6 +139,7 @@ namespace CORE {
                 case ParseError::MALFORMED_DATA: return "Malformed HTTP data";
                 case ParseError::TOO_MANY_HEADERS: return "Too many headers";
                 case ParseError::INVALID_BODY_FORMAT: return "Invalid body format";
+                case ParseError::EXPECTATION_FAILED: return "Unsupported expectation";
                 default: return "Unknown error";
             }
         }
@@ -111,6 +151,9 @@ namespace CORE {
             content_length = 0;
             headers_end_pos = 0;
             headers_count = 0;
+            expect_continue = false;
+            body_decided = false;
+            pending = Request();
         }
         
         size_t get_buffer_size() const { return buffer.size(); }
@@ -122,6 +165,9 @@ namespace CORE {
         size_t content_length = 0;
         size_t headers_end_pos = 0;
         size_t headers_count = 0;
+        bool expect_continue = false;
+        bool body_decided = false;
+        Request pending;
         
         // [Keep existing parse_request_line and parse_headers methods exactly the same]
         bool parse_request_line(Request& request) {
@@ -165,7 +211,8 @@ namespace CORE {
             line_view = line_view.substr(space2 + 1);
             request.version = std::string(line_view);
             
-            if (!is_valid_http_method(request.method) || !is_valid_http_path(request.path)) {
+            request.method_id = parse_method(request.method);
+            if (request.method_id == Method::UNKNOWN || !is_valid_http_path(request.path)) {
                 state = ParseState::ERROR;
                 error = ParseError::INVALID_REQUEST_LINE;
                 return false;
@@ -187,10 +234,10 @@ namespace CORE {
                 return false;
             }
             
-            std::string headers_section = buffer.substr(0, headers_end);
+            // The header block moves into the request once; every
+            // name/value below is a view into it, not a copy
             headers_end_pos = headers_end + 4;
-            
-            std::string_view headers_view(headers_section);
+            std::string_view headers_view = request.headers.adopt(buffer.substr(0, headers_end));
             size_t line_start = 0;
             
             while (line_start < headers_view.size()) {
@@ -215,12 +262,8 @@ namespace CORE {
                         return false;
                     }
                     
-                    std::string key = std::string(line.substr(0, colon_pos));
-                    std::string value = std::string(line.substr(colon_pos + 1));
-                    
-                    trim_inplace(key);
-                    trim_inplace(value);
-                    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+                    std::string_view key = trim_view(line.substr(0, colon_pos));
+                    std::string_view value = trim_view(line.substr(colon_pos + 1));
                     
                     if (key.empty() || !is_valid_header_name(key)) {
                         state = ParseState::ERROR;
@@ -228,38 +271,53 @@ namespace CORE {
                         return false;
                     }
                     
-                    request.headers[key] = value;
+                    request.headers.add(key, value);
                     headers_count++;
                 }
                 
                 line_start = line_end + 2;
             }
             
+            // 100-continue is the only expectation defined for HTTP/1.1;
+            // HTTP/1.0 peers must have Expect ignored
+            std::string_view expectation = request.headers.get(HeaderId::EXPECT);
+            bool wants_continue = false;
+            if (!expectation.empty() && request.version == "HTTP/1.1") {
+                if (!iequals(expectation, "100-continue")) {
+                    state = ParseState::ERROR;
+                    error = ParseError::EXPECTATION_FAILED;
+                    return false;
+                }
+                wants_continue = true;
+            }
+            
             // Check for Content-Length
-            auto content_length_it = request.headers.find("content-length");
-            if (content_length_it != request.headers.end()) {
-                try {
-                    content_length = std::stoull(content_length_it->second);
-                    if (content_length > MAX_BUFFER_SIZE) {
-                        state = ParseState::ERROR;
-                        error = ParseError::INVALID_CONTENT_LENGTH;
-                        return false;
-                    }
-                    if (content_length > 0) {
-                        state = ParseState::PARSING_BODY;
-                        return true;
-                    }
-                } catch (const std::exception&) {
+            if (request.headers.contains(HeaderId::CONTENT_LENGTH)) {
+                std::string_view length_value = request.headers.get(HeaderId::CONTENT_LENGTH);
+                auto [end_ptr, ec] = std::from_chars(length_value.data(),
+                                                     length_value.data() + length_value.size(),
+                                                     content_length);
+                if (ec != std::errc() || end_ptr != length_value.data() + length_value.size() ||
+                    length_value.empty()) {
                     state = ParseState::ERROR;
                     error = ParseError::INVALID_CONTENT_LENGTH;
                     return false;
                 }
+                if (content_length > MAX_BUFFER_SIZE) {
+                    state = ParseState::ERROR;
+                    error = ParseError::BUFFER_TOO_LARGE;
+                    return false;
+                }
+                if (content_length > 0) {
+                    expect_continue = wants_continue;
+                    state = ParseState::PARSING_BODY;
+                    return true;
+                }
             }
             
             // No body, initialize parsed body and complete
             request.parsed_body.type = BodyType::NONE;
             request.parsed_body.success = true;
-            request.parsed_body.raw_content = "";
             state = ParseState::COMPLETE;
             buffer.erase(0, headers_end_pos);
             return true;
@@ -271,19 +329,25 @@ namespace CORE {
                 return false; // Need more data
             }
             
-            // Extract raw body
-            request.body = buffer.substr(headers_end_pos, content_length);
-            buffer.erase(0, headers_end_pos + content_length);
+            // Extract raw body. When nothing is pipelined behind it, hand the
+            // whole buffer over instead of copying the body out of it.
+            if (buffer.size() == headers_end_pos + content_length) {
+                buffer.erase(0, headers_end_pos);
+                request.body = std::move(buffer);
+                buffer = std::string();
+            } else {
+                request.body = buffer.substr(headers_end_pos, content_length);
+                buffer.erase(0, headers_end_pos + content_length);
+            }
             
             // Now parse the body content based on Content-Type
             state = ParseState::PARSING_BODY_CONTENT;
             return true;
         }
         
-        // NEW: Parse body content based on Content-Type
+        // Classify the body by Content-Type. Nothing is copied or decoded
+        // here except what validation needs; see ParsedBody.
         bool parse_body_content(Request& request) {
-            // Initialize parsed body
-            request.parsed_body.raw_content = request.body;
             request.parsed_body.success = true; // Assume success unless we find errors
             
             if (request.body.empty()) {
@@ -294,20 +358,19 @@ namespace CORE {
             }
             
             // Get content type
-            auto content_type_it = request.headers.find("content-type");
-            if (content_type_it == request.headers.end()) {
+            if (!request.headers.contains(HeaderId::CONTENT_TYPE)) {
                 request.parsed_body.type = BodyType::RAW;
                 state = ParseState::COMPLETE;
                 return true;
             }
             
-            std::string content_type = to_lowercase(content_type_it->second);
+            std::string content_type = to_lowercase(std::string(request.headers.get(HeaderId::CONTENT_TYPE)));
             
             // Parse based on content type
             if (content_type.find("application/json") != std::string::npos) {
                 parse_json_body(request);
             } else if (content_type.find("application/x-www-form-urlencoded") != std::string::npos) {
-                parse_form_urlencoded_body(request);
+                request.parsed_body.type = BodyType::FORM_URLENCODED;
             } else if (content_type.find("multipart/form-data") != std::string::npos) {
                 parse_multipart_body(request, content_type);
             } else {
@@ -327,38 +390,18 @@ namespace CORE {
         
         void parse_json_body(Request& request) {
             request.parsed_body.type = BodyType::JSON;
-            request.parsed_body.json_string = request.body;
             
-            // Basic JSON validation
-            std::string trimmed = trim_copy(request.body);
-            if (trimmed.empty()) {
+            // Validate and build the DOM in the same pass, so malformed JSON
+            // is rejected with a 400 before any controller runs and
+            // Request::json() never parses the body a second time
+            auto document = std::make_shared<JsonDocument>();
+            if (!document->parse(request.body)) {
                 request.parsed_body.success = false;
-                request.parsed_body.error_message = "Empty JSON body";
+                request.parsed_body.error_message = "Invalid JSON: " + document->error();
                 return;
             }
             
-            if ((trimmed.front() == '{' && trimmed.back() == '}') ||
-                (trimmed.front() == '[' && trimmed.back() == ']')) {
-                request.parsed_body.success = true;
-            } else {
-                request.parsed_body.success = false;
-                request.parsed_body.error_message = "Invalid JSON format";
-            }
-        }
-        
-        void parse_form_urlencoded_body(Request& request) {
-            request.parsed_body.type = BodyType::FORM_URLENCODED;
-            
-            std::vector<std::string> pairs = split(request.body, '&');
-            for (const std::string& pair : pairs) {
-                size_t eq_pos = pair.find('=');
-                if (eq_pos != std::string::npos) {
-                    std::string key = url_decode(pair.substr(0, eq_pos));
-                    std::string value = url_decode(pair.substr(eq_pos + 1));
-                    request.parsed_body.form_data[key] = value;
-                }
-            }
-            
+            request.parsed_body.json_cache = std::move(document);
             request.parsed_body.success = true;
         }
         
@@ -388,68 +431,7 @@ namespace CORE {
             return result;
         }
         
-        std::string trim_copy(const std::string& str) {
-            auto start = std::find_if(str.begin(), str.end(), [](unsigned char ch) {
-                return !std::isspace(ch);
-            });
-            auto end = std::find_if(str.rbegin(), str.rend(), [](unsigned char ch) {
-                return !std::isspace(ch);
-            }).base();
-            return (start < end) ? std::string(start, end) : "";
-        }
-        
-        std::vector<std::string> split(const std::string& str, char delimiter) {
-            std::vector<std::string> result;
-            std::string current;
-            for (char c : str) {
-                if (c == delimiter) {
-                    if (!current.empty()) {
-                        result.push_back(current);
-                        current.clear();
-                    }
-                } else {
-                    current += c;
-                }
-            }
-            if (!current.empty()) {
-                result.push_back(current);
-            }
-            return result;
-        }
-        
-        std::string url_decode(const std::string& encoded) {
-            std::string decoded;
-            decoded.reserve(encoded.size());
-            
-            for (size_t i = 0; i < encoded.size(); ++i) {
-                if (encoded[i] == '%' && i + 2 < encoded.size()) {
-                    char hex_str[3] = {encoded[i+1], encoded[i+2], '\0'};
-                    char* end_ptr;
-                    long hex_value = std::strtol(hex_str, &end_ptr, 16);
-                    
-                    if (end_ptr == hex_str + 2) {
-                        decoded += static_cast<char>(hex_value);
-                        i += 2;
-                    } else {
-                        decoded += encoded[i];
-                    }
-                } else if (encoded[i] == '+') {
-                    decoded += ' ';
-                } else {
-                    decoded += encoded[i];
-                }
-            }
-            
-            return decoded;
-        }
-        
         // Keep existing validation methods
-        bool is_valid_http_method(const std::string& method) const {
-            return method == "GET" || method == "POST" || method == "PUT" || 
-                   method == "DELETE" || method == "HEAD" || method == "OPTIONS" ||
-                   method == "PATCH" || method == "TRACE" || method == "CONNECT";
-        }
-        
         bool is_valid_http_path(const std::string& path) const {
             if (path.empty() || path[0] != '/') return false;
             if (path.find("..") != std::string::npos) return false;
@@ -459,20 +441,21 @@ namespace CORE {
             return true;
         }
         
-        bool is_valid_header_name(const std::string& name) const {
+        bool is_valid_header_name(std::string_view name) const {
             for (char c : name) {
-                if (!std::isalnum(c) && c != '-' && c != '_') return false;
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') return false;
             }
             return true;
         }
         
-        void trim_inplace(std::string& str) {
-            str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](unsigned char ch) {
-                return !std::isspace(ch);
-            }));
-            str.erase(std::find_if(str.rbegin(), str.rend(), [](unsigned char ch) {
-                return !std::isspace(ch);
-            }).base(), str.end());
+        static std::string_view trim_view(std::string_view str) {
+            while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) {
+                str.remove_prefix(1);
+            }
+            while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back()))) {
+                str.remove_suffix(1);
+            }
+            return str;
         }
     };
 
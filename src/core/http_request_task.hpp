@@ -1,57 +1,86 @@
 #pragma once
 
 #include "../executor/base/task.hpp"
+#include "../executor/thread_pool.hpp"
 #include "http.hpp"
+#include "response_writer.hpp"
 #include "router.hpp"
 #include "types.hpp"
 #include <memory>
 #include <sys/socket.h>
 #include <iostream>
 #include <unistd.h>
+#include <cstring>
 
 namespace CORE {
 
     class HTTPRequestTask : public EXECUTOR::Task {
     public:
-        HTTPRequestTask(const Request& req, std::shared_ptr<ConnectionState> conn, 
-                       Router& router, bool keep_alive_enabled = false)
-            : request(req), connection(conn), router_ref(router), 
-              keep_alive_enabled(keep_alive_enabled) {}
+        static constexpr size_t RESPONSE_HEADER_RESERVE = 512;
+
+        HTTPRequestTask(Request req, std::shared_ptr<ConnectionState> conn, 
+                       Router& router, bool keep_alive_enabled = false,
+                       EXECUTOR::ThreadPool* io_pool = nullptr,
+                       EXECUTOR::ThreadPool* request_pool = nullptr)
+            : request(std::move(req)), connection(conn), router_ref(router), 
+              keep_alive_enabled(keep_alive_enabled), io_pool(io_pool), request_pool(request_pool) {}
 
         void execute(int worker_id) override {
+            request.started = std::chrono::steady_clock::now();
             Response response;
             
-            // Initialize response with defaults
-            response.status_code = 500;
-            response.status_text = "Internal Server Error";
-            response.headers["Content-Type"] = "text/plain";
-            response.headers["Server"] = "see-plus-plus/1.0";
-            
             // Determine if we should keep connection alive
             bool should_keep_alive = determine_keep_alive();
-            response.headers["Connection"] = should_keep_alive ? "keep-alive" : "close";
+            prepare_response(response, should_keep_alive);
+            
+            // The routes this request runs on, held by value: the thread's
+            // cached pointer moves on if anything here looks again after a
+            // swap, and this copy keeps the old snapshot alive until done
+            std::shared_ptr<const RouteSnapshot> routes = router_ref.snapshot();
             
             try {
-                // Try to route the request
-                if (!router_ref.route(request, response)) {
-                    response.status_code = 404;
-                    response.status_text = "Not Found";
-                    response.body = generate_404_page();
+                // Middleware may answer the request itself; otherwise it is
+                // served from the response cache or routed
+                const MiddlewareChain& middleware = routes->middleware();
+                size_t entered = 0;
+                if (middleware.run_before(request, response, entered)) {
+                    ResponseCache::Lookup cached;
+                    if (routes->caching()) {
+                        cached = router_ref.response_cache().find(request);
+                    }
+                    if (cached.entry) {
+                        cached.entry->apply(response);
+                        response.headers.set(HeaderId::CONNECTION, should_keep_alive ? "keep-alive" : "close");
+                        if (cached.refresh) {
+                            refresh_cached(router_ref, routes, request, std::move(cached.entry), io_pool);
+                        }
+                    } else if (!route_request(routes, response, should_keep_alive, entered)) {
+                        return; // Answered when the identical request ahead of it is
+                    }
                 }
                 
-                response.headers["Content-Length"] = std::to_string(response.body.size());
+                if (response.io_work && io_pool) {
+                    // The handler needs the disk: finish on the I/O executor
+                    // and free this worker for the next request
+                    io_pool->enqueue_task(std::make_unique<IOCompletionTask>(
+                        std::move(request), std::move(response), connection, should_keep_alive,
+                        routes, entered));
+                    return;
+                }
+                if (response.io_work) {
+                    auto work = std::move(response.io_work);
+                    work(request, response);
+                }
+                middleware.run_after(request, response, entered);
                 
-            } catch (const std::exception& e) {
-                response.status_code = 500;
-                response.status_text = "Internal Server Error";
-                response.body = "Internal Server Error";
-                response.headers["Content-Length"] = std::to_string(response.body.size());
+                response.headers.set(HeaderId::CONTENT_LENGTH, std::to_string(response.content_length()));
                 
-                std::cerr << "Error processing request: " << e.what() << std::endl;
+            } catch (const std::exception& e) {
+                fail_response(response, e);
                 should_keep_alive = false; // Close on error
             }
             
-            send_response(response, should_keep_alive, worker_id);
+            send_response(connection, response, should_keep_alive, worker_id);
         }
 
     private:
@@ -59,6 +88,217 @@ namespace CORE {
         std::shared_ptr<ConnectionState> connection;
         Router& router_ref;
         bool keep_alive_enabled;
+        EXECUTOR::ThreadPool* io_pool;      // Disk work
+        EXECUTOR::ThreadPool* request_pool; // The pool this task runs on, for coalesced waiters
+        
+        // Run the controller on a response-cache miss and keep what it
+        // produced if the route is cached. For a route cached with
+        // `coalesce`, a request identical to one already running is left
+        // behind it instead, and false is returned; the leader answers it.
+        bool route_request(const std::shared_ptr<const RouteSnapshot>& routes, Response& response,
+                           bool keep_alive, size_t entered) {
+            std::shared_ptr<const CachePolicy> policy;
+            if (routes->caching() && request.method_id == Method::GET) {
+                policy = routes->cache_policy(request.path);
+            }
+            
+            std::string flight;
+            if (policy && policy->coalesce) {
+                flight = ResponseCache::key(request, *policy);
+                CoalescedRequest waiter {std::move(request), std::move(response), connection, keep_alive, entered};
+                if (router_ref.flights().join(flight, std::move(waiter))) {
+                    return false;
+                }
+                request = std::move(waiter.request);
+                response = std::move(waiter.response);
+            }
+            
+            std::shared_ptr<const ResponseCache::Entry> entry;
+            try {
+                if (!routes->route(request, response)) {
+                    not_found(response);
+                }
+                if (policy) {
+                    entry = ResponseCache::make_entry(request, policy, response);
+                    if (entry) router_ref.response_cache().insert(request, entry);
+                }
+            } catch (const std::exception&) {
+                if (!flight.empty()) release_flight(router_ref, routes, flight, nullptr, request_pool, io_pool);
+                throw;
+            }
+            if (!flight.empty()) {
+                release_flight(router_ref, routes, flight, std::move(entry), request_pool, io_pool);
+            }
+            return true;
+        }
+        
+        // Answers a request that waited on an identical one: from the
+        // leader's response when it could be shared, else by running the
+        // route itself. Runs on the request pool like any request, and
+        // passes disk work on to the I/O executor the same way.
+        class CoalescedTask : public EXECUTOR::Task {
+        public:
+            CoalescedTask(std::shared_ptr<const RouteSnapshot> routes, CoalescedRequest waiter,
+                          std::shared_ptr<const ResponseCache::Entry> entry, EXECUTOR::ThreadPool* io_pool)
+                : routes(std::move(routes)), waiter(std::move(waiter)), entry(std::move(entry)),
+                  io_pool(io_pool) {}
+            
+            void execute(int worker_id) override {
+                Request& request = waiter.request;
+                Response& response = waiter.response;
+                try {
+                    if (entry) {
+                        entry->apply(response);
+                        response.headers.set(HeaderId::CONNECTION, waiter.keep_alive ? "keep-alive" : "close");
+                    } else if (!routes->route(request, response)) {
+                        not_found(response);
+                    }
+                    if (response.io_work && io_pool) {
+                        io_pool->enqueue_task(std::make_unique<IOCompletionTask>(
+                            std::move(request), std::move(response), std::move(waiter.connection),
+                            waiter.keep_alive, std::move(routes), waiter.entered));
+                        return;
+                    }
+                    if (response.io_work) {
+                        auto work = std::move(response.io_work);
+                        work(request, response);
+                    }
+                    routes->middleware().run_after(request, response, waiter.entered);
+                    response.headers.set(HeaderId::CONTENT_LENGTH, std::to_string(response.content_length()));
+                } catch (const std::exception& e) {
+                    fail_response(response, e);
+                    waiter.keep_alive = false;
+                }
+                send_response(waiter.connection, response, waiter.keep_alive, worker_id);
+            }
+            
+        private:
+            std::shared_ptr<const RouteSnapshot> routes;
+            CoalescedRequest waiter;
+            std::shared_ptr<const ResponseCache::Entry> entry;
+            EXECUTOR::ThreadPool* io_pool;
+        };
+        
+        // Close `flight` and answer everyone who waited on it, on `pool`
+        // (the request pool) if there is one. A waiter may have to run the
+        // controller itself, so they never go to the I/O executor.
+        static void release_flight(Router& router, const std::shared_ptr<const RouteSnapshot>& routes,
+                                   const std::string& flight,
+                                   std::shared_ptr<const ResponseCache::Entry> entry,
+                                   EXECUTOR::ThreadPool* pool, EXECUTOR::ThreadPool* io_pool) {
+            for (auto& waiter : router.flights().finish(flight)) {
+                auto task = std::make_unique<CoalescedTask>(routes, std::move(waiter), entry, io_pool);
+                if (pool) {
+                    pool->enqueue_task(std::move(task));
+                } else {
+                    task->execute(-1);
+                }
+            }
+        }
+        
+        static void not_found(Response& response) {
+            response.status_code = 404;
+            response.status_text = "Not Found";
+            response.headers.set(HeaderId::CONTENT_TYPE, "text/html");
+            response.shared_body = PrebuiltErrorResponse::page(404);
+        }
+        
+        // Runs a response's io_work on the I/O executor, then the
+        // middleware after() hooks, then sends it
+        class IOCompletionTask : public EXECUTOR::Task {
+        public:
+            IOCompletionTask(Request req, Response res, std::shared_ptr<ConnectionState> conn, 
+                             bool keep_alive, std::shared_ptr<const RouteSnapshot> routes, size_t entered)
+                : request(std::move(req)), response(std::move(res)), connection(std::move(conn)),
+                  keep_alive(keep_alive), routes(std::move(routes)), entered(entered) {}
+            
+            void execute(int worker_id) override {
+                try {
+                    auto work = std::move(response.io_work);
+                    work(request, response);
+                    routes->middleware().run_after(request, response, entered);
+                    response.headers.set(HeaderId::CONTENT_LENGTH, std::to_string(response.content_length()));
+                } catch (const std::exception& e) {
+                    fail_response(response, e);
+                    keep_alive = false;
+                }
+                send_response(connection, response, keep_alive, worker_id);
+            }
+            
+        private:
+            Request request;
+            Response response;
+            std::shared_ptr<ConnectionState> connection;
+            bool keep_alive;
+            std::shared_ptr<const RouteSnapshot> routes; // Keeps the middleware alive across a swap
+            size_t entered;
+        };
+        
+        // Regenerates a stale response-cache entry in the background. The
+        // stale entry is released when the task ends, however it ends (run
+        // or dropped, stored or not), so a refresh that stores nothing
+        // leaves it for the next request to try again. Once a replacement
+        // is stored, releasing the old entry changes nothing.
+        class CacheRefreshTask : public EXECUTOR::Task {
+        public:
+            CacheRefreshTask(Request req, Router& router, std::shared_ptr<const RouteSnapshot> routes,
+                             std::shared_ptr<const ResponseCache::Entry> stale)
+                : request(std::move(req)), router(router), routes(std::move(routes)), stale(std::move(stale)) {}
+            
+            ~CacheRefreshTask() override {
+                stale->refreshing.store(false, std::memory_order_release);
+            }
+            
+            void execute(int) override {
+                Response response;
+                prepare_response(response, true);
+                try {
+                    if (routes->route(request, response)) {
+                        store(response);
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error refreshing cached " << request.path << ": " << e.what() << std::endl;
+                }
+            }
+            
+        private:
+            Request request;
+            Router& router;
+            std::shared_ptr<const RouteSnapshot> routes;
+            std::shared_ptr<const ResponseCache::Entry> stale;
+            
+            void store(const Response& response) {
+                auto policy = routes->cache_policy(request.path);
+                if (!policy) return;
+                if (auto entry = ResponseCache::make_entry(request, std::move(policy), response)) {
+                    router.response_cache().insert(request, std::move(entry));
+                }
+            }
+        };
+        
+        // Status, Server, Date and Connection every response starts from,
+        // with room for the headers handlers and middleware usually add
+        static void prepare_response(Response& response, bool keep_alive) {
+            response.headers.reserve(RESPONSE_HEADER_RESERVE);
+            response.status_code = 500;
+            response.status_text = "Internal Server Error";
+            response.headers.set(HeaderId::CONTENT_TYPE, "text/plain");
+            response.headers.set(HeaderId::SERVER, SERVER_NAME);
+            response.headers.set(HeaderId::DATE, UTILS::HttpDateClock::now());
+            response.headers.set(HeaderId::CONNECTION, keep_alive ? "keep-alive" : "close");
+        }
+        
+        static void fail_response(Response& response, const std::exception& e) {
+            response.status_code = 500;
+            response.status_text = "Internal Server Error";
+            response.body = "Internal Server Error";
+            response.shared_body = nullptr;
+            response.file_body = {};
+            response.body_segments.clear();
+            response.headers.set(HeaderId::CONTENT_LENGTH, std::to_string(response.body.size()));
+            
+            std::cerr << "Error processing request: " << e.what() << std::endl;
+        }
         
         bool determine_keep_alive() {
             // Server must support keep-alive
@@ -67,59 +307,37 @@ namespace CORE {
             }
             
             // Check HTTP version - only HTTP/1.1 has keep-alive by default
+            std::string_view conn_value = request.headers.get(HeaderId::CONNECTION);
             if (request.version == "HTTP/1.1") {
                 // In HTTP/1.1, keep-alive is default unless client says "Connection: close"
-                auto conn_header = request.headers.find("connection");
-                if (conn_header != request.headers.end()) {
-                    // Convert to lowercase for comparison
-                    std::string conn_value = conn_header->second;
-                    std::transform(conn_value.begin(), conn_value.end(), 
-                                 conn_value.begin(), ::tolower);
-                    return conn_value != "close";
-                }
-                return true; // Default for HTTP/1.1
+                return !iequals(conn_value, "close");
             } else {
                 // HTTP/1.0 - keep-alive only if explicitly requested
-                auto conn_header = request.headers.find("connection");
-                if (conn_header != request.headers.end()) {
-                    std::string conn_value = conn_header->second;
-                    std::transform(conn_value.begin(), conn_value.end(), 
-                                 conn_value.begin(), ::tolower);
-                    return conn_value == "keep-alive";
-                }
-                return false; // Default for HTTP/1.0
+                return iequals(conn_value, "keep-alive");
             }
         }
         
-        void send_response(const Response& response, bool keep_alive, int worker_id) {
-            std::string response_str = response.str();
-            
-            ssize_t total_sent = 0;
-            ssize_t response_size = response_str.size();
-            
-            // Send the response
-            while (total_sent < response_size) {
-                ssize_t sent = send(connection->socket_fd, 
-                                response_str.c_str() + total_sent, 
-                                response_size - total_sent, 
-                                MSG_NOSIGNAL);
-                
-                if (sent == -1) {
-                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                        usleep(1000); // Brief pause for non-blocking socket
-                        continue;
-                    } else {
-                        std::cerr << "Failed to send response on worker " << worker_id 
-                                << ": " << strerror(errno) << std::endl;
-                        keep_alive = false; // Force close on send error
-                        break;
-                    }
-                } else if (sent == 0) {
-                    std::cerr << "Connection closed by peer during response send" << std::endl;
-                    keep_alive = false;
-                    break;
+        // Wrap up a response that is all out (or failed) and return the
+        // next one queued behind it, if any, for the caller to write
+        static std::shared_ptr<PendingWrite> finish_response(const std::shared_ptr<ConnectionState>& connection,
+                                                             WriteStatus status, bool keep_alive, int worker_id) {
+            if (status == WriteStatus::FAILED) {
+                std::cerr << "Failed to send response on worker " << worker_id 
+                        << ": " << strerror(errno) << std::endl;
+                keep_alive = false; // Force close on send error
+            }
+            
+            std::shared_ptr<PendingWrite> next;
+            {
+                std::lock_guard<std::mutex> lock(connection->write_mutex);
+                if (!keep_alive) {
+                    connection->queued_writes.clear(); // Nothing follows a close
+                }
+                if (connection->queued_writes.empty()) {
+                    connection->writing = false;
                 } else {
-                    total_sent += sent;
+                    next = std::move(connection->queued_writes.front());
+                    connection->queued_writes.pop_front();
                 }
             }
             
@@ -134,19 +352,132 @@ namespace CORE {
                 // Update last activity time for timeout management
                 connection->last_activity = std::chrono::steady_clock::now();
             }
+            return next;
+        }
+        
+        // Leave `pending` on the connection for the reactor to resume. Returns
+        // true if the socket turned writable before the reactor could see it,
+        // in which case the write has been taken back for the caller to go on.
+        static bool park_write(const std::shared_ptr<ConnectionState>& connection,
+                               const std::shared_ptr<PendingWrite>& pending) {
+            connection->last_activity = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(connection->write_mutex);
+                connection->pending_write = pending;
+            }
+            if (!ResponseWriter::wait_writable(connection->socket_fd, 0)) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(connection->write_mutex);
+            if (connection->pending_write != pending) {
+                return false; // The reactor already handed it to a worker
+            }
+            connection->pending_write.reset();
+            return true;
+        }
+
+        // Write `head` and then the body, parking whatever the socket will
+        // not take yet. While an earlier response on the connection is still
+        // going out, this one is queued behind it instead, so the bytes of
+        // the two never interleave.
+        static void send(const std::shared_ptr<ConnectionState>& connection, std::string_view head,
+                         Response& response, bool keep_alive, int worker_id) {
+            auto pending = std::make_shared<PendingWrite>();
+            {
+                std::lock_guard<std::mutex> lock(connection->write_mutex);
+                if (connection->writing) {
+                    pending->head = head;
+                    pending->response = std::move(response);
+                    pending->keep_alive = keep_alive;
+                    connection->queued_writes.push_back(std::move(pending));
+                    return;
+                }
+                connection->writing = true;
+            }
+            
+            uint64_t sent = 0;
+            WriteStatus status = ResponseWriter::write_some(connection->socket_fd, head, response, sent);
+            if (status != WriteStatus::BLOCKED) {
+                if (auto next = finish_response(connection, status, keep_alive, worker_id)) {
+                    resume_write(connection, std::move(next), worker_id);
+                }
+                return;
+            }
+            
+            pending->head = head;
+            pending->response = std::move(response);
+            pending->sent = sent;
+            pending->keep_alive = keep_alive;
+            if (park_write(connection, pending)) {
+                resume_write(connection, std::move(pending), worker_id);
+            }
+        }
+
+    public:
+        // Head from the worker's reusable buffer, body sent in place. If the
+        // socket fills up, the rest of the response is parked on the
+        // connection rather than waited for here.
+        static void send_response(const std::shared_ptr<ConnectionState>& connection, 
+                                  Response& response, bool keep_alive, int worker_id) {
+            send(connection, ResponseWriter::render_head(response), response, keep_alive, worker_id);
         }
         
-        std::string generate_404_page() {
-            return R"(<!DOCTYPE html>
-<html>
-<head><title>404 Not Found</title></head>
-<body>
-    <h1>404 - Page Not Found</h1>
-    <p>The requested resource was not found on this server.</p>
-    <p>Request: )" + request.method + " " + request.path + R"(</p>
-</body>
-</html>)";
+        // Send a response cache entry as it was stored for keep-alive:
+        // the prerendered head with Date and Age added, and the shared body
+        static void send_cached(const std::shared_ptr<ConnectionState>& connection,
+                                const ResponseCache::Entry& entry, int worker_id) {
+            Response response;
+            response.shared_body = entry.body;
+            std::string& head = ResponseWriter::head_buffer();
+            head.clear();
+            entry.render_head(head);
+            send(connection, head, response, true, worker_id);
+        }
+        
+        // Start regenerating a stale cache entry for `request`'s path, on
+        // `pool` if there is one
+        static void refresh_cached(Router& router, std::shared_ptr<const RouteSnapshot> routes, Request request,
+                                   std::shared_ptr<const ResponseCache::Entry> stale,
+                                   EXECUTOR::ThreadPool* pool) {
+            auto task = std::make_unique<CacheRefreshTask>(std::move(request), router, std::move(routes),
+                                                           std::move(stale));
+            if (pool) {
+                pool->enqueue_task(std::move(task));
+            } else {
+                task->execute(-1);
+            }
         }
+        
+        // Continue a parked response once its socket is writable again,
+        // then those queued behind it
+        static void resume_write(const std::shared_ptr<ConnectionState>& connection,
+                                 std::shared_ptr<PendingWrite> pending, int worker_id) {
+            while (pending) {
+                WriteStatus status = ResponseWriter::write_some(
+                    connection->socket_fd, pending->head, pending->response, pending->sent);
+                if (status == WriteStatus::BLOCKED) {
+                    if (!park_write(connection, pending)) return;
+                    continue;
+                }
+                pending = finish_response(connection, status, pending->keep_alive, worker_id);
+            }
+        }
+    };
+
+    // Queued by the reactor when a connection with a parked response
+    // becomes writable
+    class ResumeWriteTask : public EXECUTOR::Task {
+    public:
+        ResumeWriteTask(std::shared_ptr<ConnectionState> conn, std::shared_ptr<PendingWrite> pending)
+            : connection(std::move(conn)), pending(std::move(pending)) {}
+
+        void execute(int worker_id) override {
+            HTTPRequestTask::resume_write(connection, std::move(pending), worker_id);
+        }
+
+    private:
+        std::shared_ptr<ConnectionState> connection;
+        std::shared_ptr<PendingWrite> pending;
     };
 
 } // namespace CORE
\ No newline at end of file
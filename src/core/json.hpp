@@ -0,0 +1,761 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace CORE {
+
+    enum class JsonType : uint8_t {
+        NULL_VALUE,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    // JsonArena is a bump allocator owned by a JsonDocument. Every node and
+    // decoded string of the DOM lives in a handful of large blocks that are
+    // released together when the document goes away.
+    class JsonArena {
+    public:
+        static constexpr size_t MIN_BLOCK_SIZE = 4096;
+
+        void* allocate(size_t bytes, size_t align) {
+            size_t adjust = (align - (reinterpret_cast<uintptr_t>(cursor_) & (align - 1))) & (align - 1);
+            if (adjust + bytes > remaining_) {
+                size_t block_size = std::max(next_block_size_, bytes + align);
+                blocks_.push_back(std::make_unique<char[]>(block_size));
+                cursor_ = blocks_.back().get();
+                remaining_ = block_size;
+                next_block_size_ = block_size * 2;
+                adjust = (align - (reinterpret_cast<uintptr_t>(cursor_) & (align - 1))) & (align - 1);
+            }
+            char* result = cursor_ + adjust;
+            cursor_ += adjust + bytes;
+            remaining_ -= adjust + bytes;
+            return result;
+        }
+
+        template <typename T>
+        T* allocate_array(size_t count) {
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        // Size the first block from what the input will roughly need
+        void reserve(size_t bytes) {
+            next_block_size_ = std::max(MIN_BLOCK_SIZE, bytes);
+        }
+
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        char* cursor_ = nullptr;
+        size_t remaining_ = 0;
+        size_t next_block_size_ = MIN_BLOCK_SIZE;
+    };
+
+    struct JsonMember;
+
+    // JsonValue is a read-only DOM node. Containers point at contiguous
+    // arena arrays, so indexing an array is O(1) and objects keep their
+    // members in document order. Accessors never throw: a type mismatch or
+    // missing key yields the fallback / a null value.
+    class JsonValue {
+    public:
+        JsonType type() const { return type_; }
+        bool is_null() const { return type_ == JsonType::NULL_VALUE; }
+        bool is_bool() const { return type_ == JsonType::BOOLEAN; }
+        bool is_number() const { return type_ == JsonType::NUMBER; }
+        bool is_integer() const { return type_ == JsonType::NUMBER && is_integer_; }
+        bool is_string() const { return type_ == JsonType::STRING; }
+        bool is_array() const { return type_ == JsonType::ARRAY; }
+        bool is_object() const { return type_ == JsonType::OBJECT; }
+
+        bool as_bool(bool fallback = false) const {
+            return is_bool() ? data_.boolean : fallback;
+        }
+
+        double as_number(double fallback = 0.0) const {
+            return is_number() ? data_.number : fallback;
+        }
+
+        int64_t as_int(int64_t fallback = 0) const {
+            return is_integer() ? integer_ : fallback;
+        }
+
+        std::string_view as_string(std::string_view fallback = {}) const {
+            return is_string() ? std::string_view(data_.string, size_) : fallback;
+        }
+
+        // Number of array elements or object members
+        size_t size() const {
+            return (is_array() || is_object()) ? size_ : 0;
+        }
+
+        const JsonValue& operator[](size_t index) const {
+            return (is_array() && index < size_) ? data_.elements[index] : null_value();
+        }
+
+        const JsonValue& operator[](std::string_view key) const {
+            const JsonValue* value = find(key);
+            return value ? *value : null_value();
+        }
+
+        inline const JsonValue* find(std::string_view key) const;
+        inline const JsonMember& member(size_t index) const;
+
+        static const JsonValue& null_value() {
+            static const JsonValue null;
+            return null;
+        }
+
+    private:
+        friend class JsonParser;
+
+        JsonType type_ = JsonType::NULL_VALUE;
+        bool is_integer_ = false;
+        uint32_t size_ = 0;
+        int64_t integer_ = 0;
+        union {
+            bool boolean;
+            double number;
+            const char* string;
+            const JsonValue* elements;
+            const JsonMember* members;
+        } data_ {};
+    };
+
+    struct JsonMember {
+        std::string_view key;
+        JsonValue value;
+    };
+
+    inline const JsonValue* JsonValue::find(std::string_view key) const {
+        if (!is_object()) return nullptr;
+        for (uint32_t i = 0; i < size_; ++i) {
+            if (data_.members[i].key == key) return &data_.members[i].value;
+        }
+        return nullptr;
+    }
+
+    inline const JsonMember& JsonValue::member(size_t index) const {
+        static const JsonMember empty {};
+        return (is_object() && index < size_) ? data_.members[index] : empty;
+    }
+
+    // JsonParser validates and builds a DOM in two stages, after simdjson:
+    //
+    //  1. Structural indexing: 64-byte blocks are classified with SIMD
+    //     compares into bitmasks (quotes, backslashes, operators, whitespace).
+    //     Escapes and string interiors are resolved with branchless bit
+    //     arithmetic, leaving a list of offsets where each token starts.
+    //  2. A recursive-descent walk over that index which checks the grammar,
+    //     decodes strings and numbers and copies nodes into the arena.
+    //
+    // Scratch buffers are reused per thread, so a parse only allocates arena
+    // blocks for the resulting DOM. Passing no arena runs the same checks
+    // without building anything, which allocates nothing at all.
+    class JsonParser {
+    public:
+        static constexpr size_t MAX_DEPTH = 512;
+
+        bool parse(std::string_view input, JsonArena* arena, JsonValue& root, std::string& error) {
+            input_ = input;
+            arena_ = arena;
+            error_ = &error;
+            pos_ = 0;
+            members_.clear();
+            elements_.clear();
+
+            if (!validate_utf8(input)) {
+                return fail("Invalid UTF-8", 0);
+            }
+            if (!index_structurals(input, indexes_)) {
+                return fail("Unterminated string", input.size());
+            }
+            if (indexes_.empty()) {
+                return fail("Empty JSON document", 0);
+            }
+
+            if (arena_) {
+                arena_->reserve(input.size() + indexes_.size() * sizeof(JsonValue));
+            }
+
+            if (!parse_value(root, 0)) return false;
+            if (pos_ != indexes_.size()) {
+                return fail("Unexpected trailing content", indexes_[pos_]);
+            }
+            return true;
+        }
+
+        static JsonParser& thread_instance() {
+            thread_local JsonParser parser;
+            return parser;
+        }
+
+    private:
+        std::string_view input_;
+        JsonArena* arena_ = nullptr;
+        std::string* error_ = nullptr;
+        size_t pos_ = 0;
+        std::vector<uint32_t> indexes_;
+        std::vector<JsonMember> members_;     // Scratch stack for open objects
+        std::vector<JsonValue> elements_;     // Scratch stack for open arrays
+        std::string scratch_;                 // Decode target when only validating
+
+        bool fail(const char* message, size_t offset) {
+            *error_ = std::string(message) + " at offset " + std::to_string(offset);
+            return false;
+        }
+
+        // ---- Stage 1: structural indexing ----------------------------------
+
+        struct BlockMasks {
+            uint64_t quote = 0;
+            uint64_t backslash = 0;
+            uint64_t op = 0;
+            uint64_t whitespace = 0;
+        };
+
+        static BlockMasks classify(const char* block) {
+            BlockMasks masks;
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i case_bit = _mm_set1_epi8(0x20);
+            const __m128i open_brace = _mm_set1_epi8('{');    // '[' | 0x20 == '{'
+            const __m128i close_brace = _mm_set1_epi8('}');   // ']' | 0x20 == '}'
+            const __m128i colon = _mm_set1_epi8(':');
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i space = _mm_set1_epi8(' ');
+            const __m128i tab = _mm_set1_epi8('\t');
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i carriage = _mm_set1_epi8('\r');
+
+            for (int i = 0; i < 4; ++i) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+                __m128i folded = _mm_or_si128(v, case_bit);
+                __m128i op = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(folded, open_brace), _mm_cmpeq_epi8(folded, close_brace)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+                __m128i ws = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage)));
+
+                int shift = 16 * i;
+                masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+                masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+                masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << shift;
+                masks.whitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ws))) << shift;
+            }
+#else
+            for (int i = 0; i < 64; ++i) {
+                uint64_t bit = 1ULL << i;
+                switch (block[i]) {
+                    case '"': masks.quote |= bit; break;
+                    case '\\': masks.backslash |= bit; break;
+                    case '{': case '}': case '[': case ']': case ':': case ',':
+                        masks.op |= bit; break;
+                    case ' ': case '\t': case '\n': case '\r':
+                        masks.whitespace |= bit; break;
+                    default: break;
+                }
+            }
+#endif
+            return masks;
+        }
+
+        // Bit i is set when an odd number of quotes occur at or before i
+        static uint64_t prefix_xor(uint64_t bits) {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        // Characters preceded by an odd-length run of backslashes
+        static uint64_t find_escaped(uint64_t backslash, uint64_t& prev_escaped) {
+            constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+            backslash &= ~prev_escaped;
+            uint64_t follows_escape = (backslash << 1) | prev_escaped;
+            uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+            uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+            prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+            uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+            return (EVEN_BITS ^ invert_mask) & follows_escape;
+        }
+
+        // Fills out with the offset of every token start (operators outside
+        // strings, opening quotes, first byte of literals and numbers).
+        // Returns false if the input ends inside a string.
+        static bool index_structurals(std::string_view input, std::vector<uint32_t>& out) {
+            out.clear();
+            uint64_t prev_escaped = 0;
+            uint64_t prev_in_string = 0;
+            uint64_t prev_scalar = 0;
+
+            for (size_t base = 0; base < input.size(); base += 64) {
+                char padded[64];
+                const char* block = input.data() + base;
+                size_t remaining = input.size() - base;
+                if (remaining < 64) {
+                    std::memset(padded, ' ', sizeof(padded));
+                    std::memcpy(padded, block, remaining);
+                    block = padded;
+                }
+
+                BlockMasks masks = classify(block);
+                uint64_t escaped = find_escaped(masks.backslash, prev_escaped);
+                uint64_t quote = masks.quote & ~escaped;
+                uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+                prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+                uint64_t string_tail = in_string ^ quote;   // Interior and closing quote
+
+                uint64_t scalar = ~(masks.op | masks.whitespace);
+                uint64_t nonquote_scalar = scalar & ~quote;
+                uint64_t follows_scalar = (nonquote_scalar << 1) | prev_scalar;
+                prev_scalar = nonquote_scalar >> 63;
+
+                uint64_t structurals = (masks.op | (scalar & ~follows_scalar)) & ~string_tail;
+                while (structurals) {
+                    out.push_back(static_cast<uint32_t>(base + __builtin_ctzll(structurals)));
+                    structurals &= structurals - 1;
+                }
+            }
+            return prev_in_string == 0;
+        }
+
+        static bool validate_utf8(std::string_view input) {
+            const auto* p = reinterpret_cast<const unsigned char*>(input.data());
+            const auto* end = p + input.size();
+            while (p < end) {
+#if defined(__SSE2__)
+                // ASCII fast path, 16 bytes at a time
+                while (end - p >= 16 &&
+                       _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0) {
+                    p += 16;
+                }
+                if (p >= end) break;
+#endif
+                unsigned char c = *p;
+                if (c < 0x80) { ++p; continue; }
+
+                size_t length;
+                uint32_t code_point;
+                if ((c & 0xE0) == 0xC0) { length = 2; code_point = c & 0x1F; }
+                else if ((c & 0xF0) == 0xE0) { length = 3; code_point = c & 0x0F; }
+                else if ((c & 0xF8) == 0xF0) { length = 4; code_point = c & 0x07; }
+                else return false;
+
+                if (static_cast<size_t>(end - p) < length) return false;
+                for (size_t i = 1; i < length; ++i) {
+                    if ((p[i] & 0xC0) != 0x80) return false;
+                    code_point = (code_point << 6) | (p[i] & 0x3F);
+                }
+                // Reject overlong forms, surrogates and out-of-range values
+                if ((length == 2 && code_point < 0x80) ||
+                    (length == 3 && code_point < 0x800) ||
+                    (length == 4 && code_point < 0x10000) ||
+                    (code_point >= 0xD800 && code_point <= 0xDFFF) ||
+                    code_point > 0x10FFFF) {
+                    return false;
+                }
+                p += length;
+            }
+            return true;
+        }
+
+        // ---- Stage 2: grammar walk and DOM construction --------------------
+
+        char peek() const {
+            return pos_ < indexes_.size() ? input_[indexes_[pos_]] : '\0';
+        }
+
+        static bool is_delimiter(char c) {
+            switch (c) {
+                case ' ': case '\t': case '\n': case '\r':
+                case ',': case ':': case ']': case '}': case '[': case '{':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool delimited(size_t offset) const {
+            return offset >= input_.size() || is_delimiter(input_[offset]);
+        }
+
+        bool parse_value(JsonValue& out, size_t depth) {
+            if (pos_ >= indexes_.size()) {
+                return fail("Unexpected end of JSON", input_.size());
+            }
+            size_t offset = indexes_[pos_++];
+            switch (input_[offset]) {
+                case '{': return parse_object(out, offset, depth + 1);
+                case '[': return parse_array(out, offset, depth + 1);
+                case '"': {
+                    std::string_view text;
+                    if (!parse_string(offset, text)) return false;
+                    out.type_ = JsonType::STRING;
+                    out.data_.string = text.data();
+                    out.size_ = static_cast<uint32_t>(text.size());
+                    return true;
+                }
+                case 't': return parse_literal(out, offset, "true", JsonType::BOOLEAN, true);
+                case 'f': return parse_literal(out, offset, "false", JsonType::BOOLEAN, false);
+                case 'n': return parse_literal(out, offset, "null", JsonType::NULL_VALUE, false);
+                case '-': case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9':
+                    return parse_number(out, offset);
+                default:
+                    return fail("Unexpected character", offset);
+            }
+        }
+
+        bool parse_literal(JsonValue& out, size_t offset, std::string_view literal,
+                           JsonType type, bool value) {
+            if (input_.substr(offset, literal.size()) != literal || !delimited(offset + literal.size())) {
+                return fail("Invalid literal", offset);
+            }
+            out.type_ = type;
+            out.data_.boolean = value;
+            return true;
+        }
+
+        bool parse_object(JsonValue& out, size_t offset, size_t depth) {
+            if (depth > MAX_DEPTH) return fail("Nesting too deep", offset);
+
+            size_t start = members_.size();
+            if (peek() == '}') {
+                ++pos_;
+            } else {
+                for (;;) {
+                    if (peek() != '"') {
+                        return fail("Expected object key", pos_ < indexes_.size() ? indexes_[pos_] : input_.size());
+                    }
+                    JsonMember member;
+                    if (!parse_string(indexes_[pos_++], member.key)) return false;
+                    if (peek() != ':') {
+                        return fail("Expected ':'", pos_ < indexes_.size() ? indexes_[pos_] : input_.size());
+                    }
+                    ++pos_;
+                    if (!parse_value(member.value, depth)) return false;
+                    if (arena_) members_.push_back(member);
+
+                    char next = peek();
+                    ++pos_;
+                    if (next == ',') continue;
+                    if (next == '}') break;
+                    return fail("Expected ',' or '}'", pos_ <= indexes_.size() ? indexes_[pos_ - 1] : input_.size());
+                }
+            }
+
+            if (!arena_) return true;
+
+            size_t count = members_.size() - start;
+            JsonMember* members = arena_->allocate_array<JsonMember>(count);
+            std::copy(members_.begin() + start, members_.end(), members);
+            members_.resize(start);
+
+            out.type_ = JsonType::OBJECT;
+            out.size_ = static_cast<uint32_t>(count);
+            out.data_.members = members;
+            return true;
+        }
+
+        bool parse_array(JsonValue& out, size_t offset, size_t depth) {
+            if (depth > MAX_DEPTH) return fail("Nesting too deep", offset);
+
+            size_t start = elements_.size();
+            if (peek() == ']') {
+                ++pos_;
+            } else {
+                for (;;) {
+                    JsonValue element;
+                    if (!parse_value(element, depth)) return false;
+                    if (arena_) elements_.push_back(element);
+
+                    char next = peek();
+                    ++pos_;
+                    if (next == ',') continue;
+                    if (next == ']') break;
+                    return fail("Expected ',' or ']'", pos_ <= indexes_.size() ? indexes_[pos_ - 1] : input_.size());
+                }
+            }
+
+            if (!arena_) return true;
+
+            size_t count = elements_.size() - start;
+            JsonValue* elements = arena_->allocate_array<JsonValue>(count);
+            std::copy(elements_.begin() + start, elements_.end(), elements);
+            elements_.resize(start);
+
+            out.type_ = JsonType::ARRAY;
+            out.size_ = static_cast<uint32_t>(count);
+            out.data_.elements = elements;
+            return true;
+        }
+
+        // Length of the run starting at p with no quote, backslash or control byte
+        static size_t plain_run(const char* p, const char* end) {
+            const char* start = p;
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i control_limit = _mm_set1_epi8(0x1F);
+            while (end - p >= 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                // Unsigned v <= 0x1F  <=>  max(v, 0x1F) == 0x1F
+                __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, control_limit), control_limit);
+                __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                            _mm_cmpeq_epi8(v, backslash)), control);
+                int mask = _mm_movemask_epi8(special);
+                if (mask != 0) return (p - start) + __builtin_ctz(mask);
+                p += 16;
+            }
+#endif
+            while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) {
+                ++p;
+            }
+            return p - start;
+        }
+
+        static int hex_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool read_hex4(size_t offset, uint32_t& value) const {
+            if (offset + 4 > input_.size()) return false;
+            value = 0;
+            for (size_t i = 0; i < 4; ++i) {
+                int digit = hex_value(input_[offset + i]);
+                if (digit < 0) return false;
+                value = (value << 4) | static_cast<uint32_t>(digit);
+            }
+            return true;
+        }
+
+        static size_t encode_utf8(uint32_t code_point, char* out) {
+            if (code_point < 0x80) {
+                out[0] = static_cast<char>(code_point);
+                return 1;
+            }
+            if (code_point < 0x800) {
+                out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+                out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+                return 2;
+            }
+            if (code_point < 0x10000) {
+                out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+                out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+                return 3;
+            }
+            out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+            out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 4;
+        }
+
+        // Decode the string whose opening quote is at offset into the arena.
+        // Decoded text is never longer than its escaped source.
+        bool parse_string(size_t offset, std::string_view& result) {
+            const char* begin = input_.data() + offset + 1;
+            const char* end = input_.data() + input_.size();
+
+            // Locate the closing quote, skipping escape pairs
+            const char* p = begin;
+            bool has_escapes = false;
+            for (;;) {
+                p += plain_run(p, end);
+                if (p >= end) return fail("Unterminated string", offset);
+                if (*p == '"') break;
+                if (*p == '\\') {
+                    has_escapes = true;
+                    p += 2;
+                    continue;
+                }
+                return fail("Control character in string", p - input_.data());
+            }
+
+            size_t raw_length = p - begin;
+            if (raw_length == 0 || (!arena_ && !has_escapes)) {
+                result = std::string_view();
+                return true;
+            }
+            char* out;
+            if (arena_) {
+                out = arena_->allocate_array<char>(raw_length);
+            } else {
+                scratch_.resize(raw_length);
+                out = scratch_.data();
+            }
+            if (!has_escapes) {
+                std::memcpy(out, begin, raw_length);
+                result = std::string_view(out, raw_length);
+                return true;
+            }
+
+            size_t written = 0;
+            for (const char* q = begin; q < p;) {
+                size_t run = plain_run(q, p);
+                std::memcpy(out + written, q, run);
+                written += run;
+                q += run;
+                if (q >= p) break;
+
+                // q points at a backslash
+                size_t escape_offset = q - input_.data();
+                char code = q[1];
+                q += 2;
+                switch (code) {
+                    case '"':  out[written++] = '"'; break;
+                    case '\\': out[written++] = '\\'; break;
+                    case '/':  out[written++] = '/'; break;
+                    case 'b':  out[written++] = '\b'; break;
+                    case 'f':  out[written++] = '\f'; break;
+                    case 'n':  out[written++] = '\n'; break;
+                    case 'r':  out[written++] = '\r'; break;
+                    case 't':  out[written++] = '\t'; break;
+                    case 'u': {
+                        uint32_t code_point;
+                        if (!read_hex4(q - input_.data(), code_point)) {
+                            return fail("Invalid unicode escape", escape_offset);
+                        }
+                        q += 4;
+                        if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                            uint32_t low;
+                            if (q + 1 >= p || q[0] != '\\' || q[1] != 'u' ||
+                                !read_hex4(q + 2 - input_.data(), low) ||
+                                low < 0xDC00 || low > 0xDFFF) {
+                                return fail("Invalid surrogate pair", escape_offset);
+                            }
+                            q += 6;
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        } else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+                            return fail("Invalid surrogate pair", escape_offset);
+                        }
+                        written += encode_utf8(code_point, out + written);
+                        break;
+                    }
+                    default:
+                        return fail("Invalid escape sequence", escape_offset);
+                }
+            }
+
+            result = std::string_view(out, written);
+            return true;
+        }
+
+        bool parse_number(JsonValue& out, size_t offset) {
+            const char* start = input_.data() + offset;
+            const char* end = input_.data() + input_.size();
+            const char* p = start;
+            auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+            bool negative = (*p == '-');
+            if (negative) ++p;
+            if (p >= end || !is_digit(*p)) return fail("Invalid number", offset);
+
+            const char* digits_start = p;
+            if (*p == '0') {
+                ++p;
+            } else {
+                while (p < end && is_digit(*p)) ++p;
+            }
+            size_t integer_digits = p - digits_start;
+
+            bool integral = true;
+            if (p < end && *p == '.') {
+                integral = false;
+                ++p;
+                if (p >= end || !is_digit(*p)) return fail("Invalid number", offset);
+                while (p < end && is_digit(*p)) ++p;
+            }
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                integral = false;
+                ++p;
+                if (p < end && (*p == '+' || *p == '-')) ++p;
+                if (p >= end || !is_digit(*p)) return fail("Invalid number", offset);
+                while (p < end && is_digit(*p)) ++p;
+            }
+            if (!delimited(p - input_.data())) return fail("Invalid number", offset);
+
+            out.type_ = JsonType::NUMBER;
+            if (integral && integer_digits <= 18) {
+                // Exact for anything that fits in 18 digits, no strtod needed
+                int64_t value = 0;
+                for (const char* d = digits_start; d < p; ++d) {
+                    value = value * 10 + (*d - '0');
+                }
+                out.is_integer_ = true;
+                out.integer_ = negative ? -value : value;
+                out.data_.number = static_cast<double>(out.integer_);
+                return true;
+            }
+
+            char stack_buffer[64];
+            size_t length = p - start;
+            std::string heap_buffer;
+            const char* text = stack_buffer;
+            if (length < sizeof(stack_buffer)) {
+                std::memcpy(stack_buffer, start, length);
+                stack_buffer[length] = '\0';
+            } else {
+                heap_buffer.assign(start, length);
+                text = heap_buffer.c_str();
+            }
+            out.data_.number = std::strtod(text, nullptr);
+            return true;
+        }
+    };
+
+    // JsonDocument owns a parsed DOM and the arena backing it
+    class JsonDocument {
+    public:
+        bool parse(std::string_view input) {
+            error_.clear();
+            root_ = JsonValue();
+            valid_ = JsonParser::thread_instance().parse(input, &arena_, root_, error_);
+            if (!valid_) root_ = JsonValue();
+            return valid_;
+        }
+
+        // Full validation without building a DOM; allocates nothing unless
+        // the input is invalid (for the error message)
+        static bool validate(std::string_view input, std::string& error) {
+            JsonValue ignored;
+            return JsonParser::thread_instance().parse(input, nullptr, ignored, error);
+        }
+
+        bool is_valid() const { return valid_; }
+        const JsonValue& root() const { return root_; }
+        const std::string& error() const { return error_; }
+
+    private:
+        JsonArena arena_;
+        JsonValue root_;
+        std::string error_;
+        bool valid_ = false;
+    };
+
+} // namespace CORE
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "http.hpp"
+#include <memory>
+#include <vector>
+
+namespace CORE {
+
+    // MiddlewareChain runs code around every request. A middleware is any
+    // type with
+    //
+    //   bool before(Request&, Response&);       // false = answered, stop here
+    //   void after(const Request&, Response&);
+    //
+    // before() hooks run in the order added, then the route (unless one
+    // returned false), then after() hooks in reverse for each middleware
+    // whose before() let the request through, so outer layers such as CORS
+    // still see a response written by an inner one like auth. after() sees
+    // the finished response, including any io_work the handler deferred,
+    // and may run on an I/O worker rather than the one that ran before().
+    //
+    // The chain is composed at startup into a flat array of plain function
+    // pointers that call each type's hooks by qualified name: running it is
+    // an indexed loop with one direct call per hook, no virtual dispatch and
+    // no allocation. Middlewares are shared by all workers, so hooks must be
+    // safe to call concurrently.
+    class MiddlewareChain {
+    public:
+        template <typename M>
+        void add(std::shared_ptr<M> middleware) {
+            steps_.push_back(Step{
+                middleware.get(),
+                [](void* self, Request& req, Response& res) {
+                    return static_cast<M*>(self)->M::before(req, res);
+                },
+                [](void* self, const Request& req, Response& res) {
+                    static_cast<M*>(self)->M::after(req, res);
+                }});
+            owners_.push_back(std::move(middleware));
+        }
+
+        bool empty() const { return steps_.empty(); }
+
+        // Run before() hooks; `entered` counts those that let the request
+        // through and is what run_after() needs. False if one answered it.
+        bool run_before(Request& req, Response& res, size_t& entered) const {
+            for (entered = 0; entered < steps_.size(); ++entered) {
+                const Step& step = steps_[entered];
+                if (!step.before(step.self, req, res)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void run_after(const Request& req, Response& res, size_t entered) const {
+            while (entered > 0) {
+                const Step& step = steps_[--entered];
+                step.after(step.self, req, res);
+            }
+        }
+
+    private:
+        struct Step {
+            void* self;
+            bool (*before)(void*, Request&, Response&);
+            void (*after)(void*, const Request&, Response&);
+        };
+
+        std::vector<Step> steps_;
+        std::vector<std::shared_ptr<void>> owners_; // Keeps each middleware alive
+    };
+
+} // namespace CORE
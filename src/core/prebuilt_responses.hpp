@@ -0,0 +1,161 @@
+#pragma once
+
+#include "../utils/http_date.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+
+namespace CORE {
+
+    inline constexpr std::string_view SERVER_NAME = "see-plus-plus/1.0";
+
+    // Standard reason phrase for the status codes we emit; empty otherwise
+    constexpr std::string_view reason_phrase(int status_code) {
+        switch (status_code) {
+            case 100: return "Continue";
+            case 200: return "OK";
+            case 204: return "No Content";
+            case 206: return "Partial Content";
+            case 301: return "Moved Permanently";
+            case 302: return "Found";
+            case 304: return "Not Modified";
+            case 400: return "Bad Request";
+            case 401: return "Unauthorized";
+            case 403: return "Forbidden";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 412: return "Precondition Failed";
+            case 413: return "Request Entity Too Large";
+            case 416: return "Range Not Satisfiable";
+            case 417: return "Expectation Failed";
+            case 500: return "Internal Server Error";
+            case 503: return "Service Unavailable";
+            default:  return {};
+        }
+    }
+
+    // Complete "HTTP/1.1 <code> <reason>\r\n" line for the same codes, so
+    // serializing a common status is a single append
+    constexpr std::string_view status_line(int status_code) {
+        switch (status_code) {
+            case 100: return "HTTP/1.1 100 Continue\r\n";
+            case 200: return "HTTP/1.1 200 OK\r\n";
+            case 204: return "HTTP/1.1 204 No Content\r\n";
+            case 206: return "HTTP/1.1 206 Partial Content\r\n";
+            case 301: return "HTTP/1.1 301 Moved Permanently\r\n";
+            case 302: return "HTTP/1.1 302 Found\r\n";
+            case 304: return "HTTP/1.1 304 Not Modified\r\n";
+            case 400: return "HTTP/1.1 400 Bad Request\r\n";
+            case 401: return "HTTP/1.1 401 Unauthorized\r\n";
+            case 403: return "HTTP/1.1 403 Forbidden\r\n";
+            case 404: return "HTTP/1.1 404 Not Found\r\n";
+            case 405: return "HTTP/1.1 405 Method Not Allowed\r\n";
+            case 412: return "HTTP/1.1 412 Precondition Failed\r\n";
+            case 413: return "HTTP/1.1 413 Request Entity Too Large\r\n";
+            case 416: return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+            case 417: return "HTTP/1.1 417 Expectation Failed\r\n";
+            case 500: return "HTTP/1.1 500 Internal Server Error\r\n";
+            case 503: return "HTTP/1.1 503 Service Unavailable\r\n";
+            default:  return {};
+        }
+    }
+
+    // PrebuiltErrorResponse is the complete wire image of a server-generated
+    // error (HTML body, Connection: close), rendered once per status code.
+    // Only the Date value changes between sends, so the bytes are kept as
+    // the part before it and the part after it, and go out as three iovecs.
+    class PrebuiltErrorResponse {
+    public:
+        // Codes with a cached page; anything else is rendered as 500
+        static const PrebuiltErrorResponse& get(int status_code) {
+            static const PrebuiltErrorResponse bad_request(400);
+            static const PrebuiltErrorResponse unauthorized(401);
+            static const PrebuiltErrorResponse forbidden(403);
+            static const PrebuiltErrorResponse not_found(404);
+            static const PrebuiltErrorResponse not_allowed(405);
+            static const PrebuiltErrorResponse too_large(413);
+            static const PrebuiltErrorResponse expectation_failed(417);
+            static const PrebuiltErrorResponse internal_error(500);
+            static const PrebuiltErrorResponse unavailable(503);
+
+            switch (status_code) {
+                case 400: return bad_request;
+                case 401: return unauthorized;
+                case 403: return forbidden;
+                case 404: return not_found;
+                case 405: return not_allowed;
+                case 413: return too_large;
+                case 417: return expectation_failed;
+                case 503: return unavailable;
+                default:  return internal_error;
+            }
+        }
+
+        // HTML error page body for a status code, shared by every error
+        // response the server produces itself: set it as
+        // Response::shared_body rather than copying it into the response
+        static const std::shared_ptr<const std::string>& page(int status_code) {
+            return get(status_code).body_;
+        }
+
+        // Fill `iov` (3 entries) with head, current Date and tail
+        void to_iovecs(iovec* iov, std::string_view date) const {
+            iov[0].iov_base = const_cast<char*>(head_.data());
+            iov[0].iov_len = head_.size();
+            iov[1].iov_base = const_cast<char*>(date.data());
+            iov[1].iov_len = date.size();
+            iov[2].iov_base = const_cast<char*>(tail_.data());
+            iov[2].iov_len = tail_.size();
+        }
+
+        int status_code() const { return status_code_; }
+
+    private:
+        int status_code_;
+        std::shared_ptr<const std::string> body_;
+        std::string head_;   // status line and headers up to "Date: "
+        std::string tail_;   // end of the Date line, blank line, body
+
+        explicit PrebuiltErrorResponse(int status_code) : status_code_(status_code) {
+            std::string code = std::to_string(status_code);
+            std::string title = code + " " + std::string(reason_phrase(status_code));
+
+            std::string body = R"(<!DOCTYPE html>
+<html>
+<head><title>)" + title + R"(</title></head>
+<body>
+    <h1>)" + title + R"(</h1>
+    <p>)" + std::string(description(status_code)) + R"(</p>
+    <hr>
+    <small>)" + std::string(SERVER_NAME) + R"(</small>
+</body>
+</html>)";
+            body_ = std::make_shared<const std::string>(std::move(body));
+
+            head_.append(status_line(status_code));
+            head_.append("Content-Type: text/html\r\n");
+            head_.append("Connection: close\r\n");
+            head_.append("Server: ").append(SERVER_NAME).append("\r\n");
+            head_.append("Content-Length: ").append(std::to_string(body_->size())).append("\r\n");
+            head_.append("Date: ");
+
+            tail_.append("\r\n\r\n");
+            tail_.append(*body_);
+        }
+
+        static constexpr std::string_view description(int status_code) {
+            switch (status_code) {
+                case 403: return "You do not have permission to access this resource.";
+                case 404: return "The requested resource was not found on this server.";
+                case 405: return "The request method is not supported for this resource.";
+                case 413: return "The request body exceeds the server's size limit.";
+                case 417: return "The server cannot meet the request's Expect header.";
+                case 503: return "The server is temporarily unable to handle the request.";
+                default:  return "The server encountered an error processing your request.";
+            }
+        }
+    };
+
+} // namespace CORE
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "http.hpp"
+#include "types.hpp"
+#include "../utils/http_date.hpp"
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CORE {
+
+    // How a route's GET responses are cached (see Router::cache_route)
+    struct CachePolicy {
+        std::chrono::milliseconds ttl {1000};                // Served without running the controller
+        std::chrono::milliseconds stale_while_revalidate {0}; // Then served stale while one refresh runs
+        std::vector<std::string> vary {};                    // Request headers that pick a variant
+        bool coalesce = false; // Concurrent misses wait for one controller run (see Router::flights)
+    };
+
+    // A request parked behind an identical one that is already running its
+    // controller, with what is needed to answer it from that one's result
+    struct CoalescedRequest {
+        Request request;
+        Response response;   // As the middleware before() hooks left it
+        std::shared_ptr<ConnectionState> connection;
+        bool keep_alive = false;
+        size_t entered = 0;  // How many middleware after() hooks to run
+    };
+
+    // ResponseCache keeps the responses of opted-in routes, keyed on path
+    // and query plus the values of the policy's Vary headers. Each entry is
+    // held twice: as parts (status, headers, shared body) for workers that
+    // still run middleware around it, and as a prerendered keep-alive head,
+    // which the reactor sends with only Date and Age appended and no task,
+    // routing or header serialization. What is stored is the controller's
+    // output, before any middleware after() hook, so hooks apply fresh to
+    // every hit. Date is left out and Age added on the way out, so a hit
+    // never claims to be newer than it is; the policy's Vary headers are
+    // advertised so downstream caches keep the variants apart too. A
+    // response that varies on a header the policy does not key on (a gzip
+    // body chosen by Accept-Encoding, say) is not stored at all.
+    //
+    // Once an entry is past its TTL but inside stale_while_revalidate, the
+    // first lookup to notice is told to refresh it and everyone keeps
+    // getting the stale copy until the new one is stored. A refresh that
+    // stores nothing hands the job to the next lookup.
+    //
+    // A policy with a zero TTL and no stale window stores nothing; with
+    // `coalesce` set it still shares one response among concurrent misses.
+    class ResponseCache {
+    public:
+        static constexpr size_t MAX_ENTRIES = 4096;
+        static constexpr size_t MAX_BODY_SIZE = 256 * 1024;
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry {
+            std::string path;                          // Path with query
+            std::shared_ptr<const CachePolicy> policy;
+            std::vector<std::string> vary_values;      // Parallel to policy->vary
+            uint16_t status_code = 0;
+            std::string status_text;
+            Headers headers;
+            std::shared_ptr<const std::string> body;
+            std::string head;      // Keep-alive status line and headers, less Date, Age and the blank line
+            Clock::time_point stored;
+            Clock::time_point fresh_until;
+            Clock::time_point stale_until;
+            mutable std::atomic<bool> refreshing {false};
+
+            // Fill `res` from the entry, over any headers already set (the
+            // fresh Date among them); Content-Length and Connection are left
+            // to the caller
+            void apply(Response& res) const {
+                res.status_code = status_code;
+                res.status_text = status_text;
+                for (auto field : headers) {
+                    res.headers.set(field.name, field.value);
+                }
+                char age[24];
+                res.headers.set("Age", std::string_view(age, age_of(Clock::now(), age) - age));
+                res.body.clear();
+                res.shared_body = body;
+            }
+
+            // Append the whole keep-alive head, with the current Date and
+            // Age, to `out`
+            void render_head(std::string& out) const {
+                char age[24];
+                char* age_end = age_of(Clock::now(), age);
+                out.append(head);
+                out.append("Date: ", 6);
+                out.append(UTILS::HttpDateClock::now());
+                out.append("\r\nAge: ", 7);
+                out.append(age, age_end - age);
+                out.append("\r\n\r\n", 4);
+            }
+
+            // Whole seconds since the response was generated, as digits
+            char* age_of(Clock::time_point now, char* out) const {
+                auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now - stored).count();
+                return std::to_chars(out, out + 20, seconds < 0 ? 0 : seconds).ptr;
+            }
+        };
+
+        struct Lookup {
+            std::shared_ptr<const Entry> entry;  // Null on a miss
+            bool refresh = false;                // Caller should regenerate it
+        };
+
+        Lookup find(const Request& req) const {
+            Lookup result;
+            if (req.method_id != Method::GET) return result;
+
+            Clock::time_point now = Clock::now();
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto bucket = entries_.find(req.path);
+            if (bucket == entries_.end()) return result;
+
+            for (const auto& entry : bucket->second) {
+                if (!selects(*entry, req) || now >= entry->stale_until) continue;
+                result.entry = entry;
+                result.refresh = now >= entry->fresh_until &&
+                                 !entry->refreshing.exchange(true, std::memory_order_acq_rel);
+                break;
+            }
+            return result;
+        }
+
+        // Identifies the variant of `req` that `policy` selects: the path
+        // with query, then each Vary header's value
+        static std::string key(const Request& req, const CachePolicy& policy) {
+            std::string key = req.path;
+            for (const auto& name : policy.vary) {
+                key += '\0';
+                key += req.headers.get(name);
+            }
+            return key;
+        }
+
+        // Package `res` as the response to `req` if it may be handed to
+        // other clients: built in memory, small enough, not carrying
+        // cookies or marked private, and varying on no request header the
+        // policy does not key on. Null otherwise.
+        static std::shared_ptr<Entry> make_entry(const Request& req, std::shared_ptr<const CachePolicy> policy,
+                                                 const Response& res) {
+            if (!shareable(res, *policy)) return nullptr;
+
+            auto entry = std::make_shared<Entry>();
+            entry->path = req.path;
+            entry->vary_values.reserve(policy->vary.size());
+            for (const auto& name : policy->vary) {
+                entry->vary_values.emplace_back(req.headers.get(name));
+            }
+            entry->status_code = res.status_code;
+            entry->status_text = res.status_text;
+            for (auto field : res.headers) {
+                if (!iequals(field.name, "Date") && !iequals(field.name, "Age")) {
+                    entry->headers.add(field.name, field.value);
+                }
+            }
+            if (!policy->vary.empty()) {
+                std::string vary(res.headers.get(HeaderId::VARY));
+                for (const auto& name : policy->vary) {
+                    if (lists(vary, name)) continue;
+                    if (!vary.empty()) vary += ", ";
+                    vary += name;
+                }
+                entry->headers.set(HeaderId::VARY, vary);
+            }
+            entry->body = res.shared_body ? res.shared_body : std::make_shared<const std::string>(res.body);
+            entry->head = render_head(*entry);
+            entry->stored = Clock::now();
+            entry->fresh_until = entry->stored + policy->ttl;
+            entry->stale_until = entry->fresh_until + policy->stale_while_revalidate;
+            entry->policy = std::move(policy);
+            return entry;
+        }
+
+        // Keep `entry` for later lookups if it is a GET 200 and its policy
+        // caches at all, replacing the variant it was built for. Returns
+        // whether it was stored.
+        bool insert(const Request& req, std::shared_ptr<const Entry> entry) {
+            if (req.method_id != Method::GET || entry->status_code != 200) return false;
+            Clock::time_point now = Clock::now();
+            if (entry->stale_until <= now) return false;
+
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            auto bucket = entries_.find(entry->path);
+            if (bucket != entries_.end()) {
+                for (auto& existing : bucket->second) {
+                    if (existing->policy == entry->policy && existing->vary_values == entry->vary_values) {
+                        existing = std::move(entry);
+                        return true;
+                    }
+                }
+            }
+            if (count_ >= MAX_ENTRIES && !evict_expired(now)) {
+                return false;
+            }
+            entries_[entry->path].push_back(std::move(entry));
+            ++count_;
+            return true;
+        }
+
+        void clear() {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            entries_.clear();
+            count_ = 0;
+        }
+
+    private:
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<std::string, std::vector<std::shared_ptr<const Entry>>> entries_;
+        size_t count_ = 0;
+
+        static bool selects(const Entry& entry, const Request& req) {
+            for (size_t i = 0; i < entry.vary_values.size(); ++i) {
+                if (req.headers.get(entry.policy->vary[i]) != entry.vary_values[i]) return false;
+            }
+            return true;
+        }
+
+        static bool shareable(const Response& res, const CachePolicy& policy) {
+            if (res.io_work || res.file_body.file || !res.body_segments.empty()) return false;
+            if (res.content_length() > MAX_BODY_SIZE || res.headers.contains("Set-Cookie")) return false;
+
+            // A response chosen by a request header the key leaves out (say
+            // a gzip body for Accept-Encoding) would be replayed to clients
+            // that did not ask for it; "*" matches no header and is refused
+            bool keyed = true;
+            for_each_name(res.headers.get(HeaderId::VARY), [&](std::string_view name) {
+                bool covered = false;
+                for (const auto& vary : policy.vary) {
+                    covered = covered || iequals(name, vary);
+                }
+                keyed = keyed && covered;
+            });
+            if (!keyed) return false;
+
+            std::string_view cache_control = res.headers.get(HeaderId::CACHE_CONTROL);
+            return cache_control.find("no-store") == std::string_view::npos &&
+                   cache_control.find("private") == std::string_view::npos;
+        }
+
+        // Calls fn with each name in a comma-separated header list
+        template <typename Fn>
+        static void for_each_name(std::string_view list, Fn&& fn) {
+            while (!list.empty()) {
+                size_t comma = list.find(',');
+                std::string_view name = list.substr(0, comma);
+                while (!name.empty() && (name.front() == ' ' || name.front() == '\t')) name.remove_prefix(1);
+                while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) name.remove_suffix(1);
+                if (!name.empty()) fn(name);
+                list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+            }
+        }
+
+        static bool lists(std::string_view list, std::string_view name) {
+            bool found = false;
+            for_each_name(list, [&](std::string_view listed) { found = found || iequals(listed, name); });
+            return found;
+        }
+
+        static std::string render_head(const Entry& entry) {
+            Response res;
+            res.status_code = entry.status_code;
+            res.status_text = entry.status_text;
+            res.headers = entry.headers;
+            res.headers.set(HeaderId::CONNECTION, "keep-alive");
+            res.headers.set(HeaderId::CONTENT_LENGTH, std::to_string(entry.body->size()));
+            std::string head;
+            res.serialize_head(head);
+            head.resize(head.size() - 2); // Date and Age go last, per hit
+            return head;
+        }
+
+        // Drop entries that can no longer be served; false if none could go
+        bool evict_expired(Clock::time_point now) {
+            size_t before = count_;
+            for (auto bucket = entries_.begin(); bucket != entries_.end();) {
+                auto& list = bucket->second;
+                for (size_t i = 0; i < list.size();) {
+                    if (now >= list[i]->stale_until) {
+                        list[i] = std::move(list.back());
+                        list.pop_back();
+                        --count_;
+                    } else {
+                        ++i;
+                    }
+                }
+                bucket = list.empty() ? entries_.erase(bucket) : std::next(bucket);
+            }
+            return count_ < before;
+        }
+    };
+
+} // namespace CORE
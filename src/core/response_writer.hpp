@@ -0,0 +1,292 @@
+#pragma once
+
+#include "http.hpp"
+#include "prebuilt_responses.hpp"
+#include "../utils/http_date.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+#elif defined(__APPLE__)
+    #include <sys/types.h>
+#endif
+
+namespace CORE {
+
+    enum class WriteStatus {
+        DONE,      // Every byte is on the wire
+        BLOCKED,   // The socket buffer is full; resume when it is writable
+        FAILED     // Socket error, errno set
+    };
+
+    // A response whose send stopped on a full socket buffer. It owns all
+    // the rest of the send needs, and `sent` counts the bytes already out.
+    struct PendingWrite {
+        std::string head;
+        Response response;
+        uint64_t sent = 0;
+        bool keep_alive = false;
+    };
+
+    // ResponseWriter puts a Response on the wire without building it into
+    // one string. The status line and headers are rendered into a buffer
+    // owned by the calling thread and reused across responses; the body is
+    // sent straight from Response::body (or shared_body). In-memory pieces
+    // go out together in one sendmsg() call; file-backed pieces
+    // (Response::file_body, body_segments) follow via sendfile().
+    //
+    // write_some() never waits: it sends what the socket takes and reports
+    // BLOCKED with a byte cursor, so a slow reader costs a parked
+    // PendingWrite instead of a worker thread. Large files therefore stream
+    // straight from the page cache in whatever windows the socket accepts.
+    class ResponseWriter {
+    public:
+        // Initial capacity of the per-thread head buffer; enough for the
+        // status line and a typical header set, so it never reallocates
+        static constexpr size_t HEAD_BUFFER_RESERVE = 1024;
+
+        // The calling thread's reusable buffer for a response head
+        static std::string& head_buffer() {
+            thread_local std::string buffer = [] {
+                std::string b;
+                b.reserve(HEAD_BUFFER_RESERVE);
+                return b;
+            }();
+            return buffer;
+        }
+
+        // Render the status line and headers into the calling thread's
+        // head buffer, valid until the thread's next render_head()
+        static std::string& render_head(const Response& response) {
+            std::string& head = head_buffer();
+            head.clear();
+            response.serialize_head(head);
+            return head;
+        }
+
+        // Send `head` and the body from byte `sent` on, advancing `sent`
+        static WriteStatus write_some(int fd, std::string_view head, const Response& response,
+                                      uint64_t& sent) {
+            std::vector<Piece>& pieces = piece_buffer();
+            collect_pieces(head, response, pieces);
+
+            // Find the first piece not yet fully sent
+            size_t index = 0;
+            uint64_t skip = sent;
+            while (index < pieces.size() && skip >= pieces[index].length) {
+                skip -= pieces[index].length;
+                ++index;
+            }
+
+            while (index < pieces.size()) {
+                uint64_t progressed = 0;
+                WriteStatus status;
+                if (pieces[index].file) {
+                    status = send_file_some(fd, *pieces[index].file, skip, progressed);
+                } else {
+                    status = send_memory_some(fd, pieces, index, skip, progressed);
+                }
+                sent += progressed;
+                if (status != WriteStatus::DONE) {
+                    return status;
+                }
+
+                // Step over whatever that call completed
+                skip += progressed;
+                while (index < pieces.size() && skip >= pieces[index].length) {
+                    skip -= pieces[index].length;
+                    ++index;
+                }
+            }
+            return WriteStatus::DONE;
+        }
+
+        // Send a prebuilt error response with the current Date spliced in,
+        // in a single non-blocking sendmsg(). The reactor sends these and
+        // then closes the connection, so it never waits on a client that
+        // stopped reading: false (errno EAGAIN) if the socket took only part.
+        static bool write(int fd, const PrebuiltErrorResponse& prebuilt) {
+            iovec iov[3];
+            prebuilt.to_iovecs(iov, UTILS::HttpDateClock::now());
+            size_t total = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+
+            msghdr msg {};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 3;
+            ssize_t sent;
+            do {
+                sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+            } while (sent == -1 && errno == EINTR);
+            if (sent >= 0 && static_cast<size_t>(sent) < total) {
+                errno = EAGAIN;
+                return false;
+            }
+            return sent >= 0;
+        }
+
+        // True once the socket can take more data, or on timeout false
+        static bool wait_writable(int fd, int timeout_ms) {
+            pollfd pfd {fd, POLLOUT, 0};
+            int ready;
+            do {
+                ready = poll(&pfd, 1, timeout_ms);
+            } while (ready == -1 && errno == EINTR);
+            if (ready == 0) errno = EAGAIN;
+            return ready > 0 && (pfd.revents & POLLOUT);
+        }
+
+    private:
+#ifdef MSG_MORE
+        static constexpr int MORE_FLAG = MSG_MORE;
+#else
+        static constexpr int MORE_FLAG = 0;
+#endif
+        static constexpr size_t MAX_IOVECS = 16;
+
+        // One contiguous part of the response: bytes in memory, or a file range
+        struct Piece {
+            const char* data;
+            uint64_t length;
+            const UTILS::FileSlice* file;
+        };
+
+        static void collect_pieces(std::string_view head, const Response& response,
+                                   std::vector<Piece>& pieces) {
+            pieces.clear();
+            add_memory(pieces, head);
+            if (!response.body_segments.empty()) {
+                for (const BodySegment& segment : response.body_segments) {
+                    add_memory(pieces, segment.text);
+                    if (segment.file) {
+                        pieces.push_back(Piece{nullptr, segment.file.length, &segment.file});
+                    }
+                }
+                return;
+            }
+            add_memory(pieces, response.memory_body());
+            if (response.file_body) {
+                pieces.push_back(Piece{nullptr, response.file_body.length, &response.file_body});
+            }
+        }
+
+        static void add_memory(std::vector<Piece>& pieces, std::string_view bytes) {
+            if (!bytes.empty()) {
+                pieces.push_back(Piece{bytes.data(), bytes.size(), nullptr});
+            }
+        }
+
+        // One sendmsg() over the run of memory pieces starting at `index`,
+        // corked if more of the response follows
+        static WriteStatus send_memory_some(int fd, const std::vector<Piece>& pieces, size_t index,
+                                            uint64_t skip, uint64_t& progressed) {
+            iovec iov[MAX_IOVECS];
+            size_t count = 0;
+            size_t next = index;
+            while (next < pieces.size() && !pieces[next].file && count < MAX_IOVECS) {
+                uint64_t offset = next == index ? skip : 0;
+                iov[count].iov_base = const_cast<char*>(pieces[next].data) + offset;
+                iov[count].iov_len = pieces[next].length - offset;
+                ++count;
+                ++next;
+            }
+            int flags = MSG_NOSIGNAL | (next < pieces.size() ? MORE_FLAG : 0);
+
+            while (count > 0) {
+                msghdr msg {};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = count;
+                ssize_t sent = sendmsg(fd, &msg, flags);
+                if (sent == -1) {
+                    if (errno == EINTR) continue;
+                    return (errno == EAGAIN || errno == EWOULDBLOCK) ? WriteStatus::BLOCKED
+                                                                     : WriteStatus::FAILED;
+                }
+                progressed += static_cast<uint64_t>(sent);
+                size_t live = count;
+                iovec* first = iov;
+                advance(first, live, static_cast<size_t>(sent));
+                if (live == 0) break;
+                // Move the unsent tail to the front and go again
+                for (size_t i = 0; i < live; ++i) iov[i] = first[i];
+                count = live;
+            }
+            return WriteStatus::DONE;
+        }
+
+        // Send a file range from byte `skip` with sendfile(2). For a regular
+        // file to a TCP socket this is the single-copy path; splice(2) would
+        // need a pipe in between for the same result. Platforms without
+        // sendfile fall back to pread() through a per-thread buffer.
+        static WriteStatus send_file_some(int fd, const UTILS::FileSlice& slice, uint64_t skip,
+                                          uint64_t& progressed) {
+            off_t offset = static_cast<off_t>(slice.offset + skip);
+            uint64_t remaining = slice.length - skip;
+
+            while (remaining > 0) {
+#if defined(__linux__)
+                ssize_t sent = sendfile(fd, slice.file->fd(), &offset, remaining);
+                if (sent == 0) return WriteStatus::FAILED; // File shrank underneath us
+                if (sent > 0) {
+                    remaining -= static_cast<uint64_t>(sent);
+                    progressed += static_cast<uint64_t>(sent);
+                    continue;
+                }
+#elif defined(__APPLE__)
+                off_t length = static_cast<off_t>(remaining);
+                int rc = sendfile(slice.file->fd(), fd, offset, &length, nullptr, 0);
+                // Partial progress is reported through `length` even on EAGAIN
+                offset += length;
+                remaining -= static_cast<uint64_t>(length);
+                progressed += static_cast<uint64_t>(length);
+                if (rc == 0) {
+                    if (length == 0) return WriteStatus::FAILED; // File shrank underneath us
+                    continue;
+                }
+#else
+                static constexpr size_t FALLBACK_CHUNK = 64 * 1024;
+                thread_local char chunk[FALLBACK_CHUNK];
+                ssize_t got = pread(slice.file->fd(), chunk,
+                                    remaining < FALLBACK_CHUNK ? remaining : FALLBACK_CHUNK, offset);
+                if (got <= 0) return WriteStatus::FAILED;
+                ssize_t sent = send(fd, chunk, static_cast<size_t>(got), MSG_NOSIGNAL);
+                if (sent > 0) {
+                    offset += sent;
+                    remaining -= static_cast<uint64_t>(sent);
+                    progressed += static_cast<uint64_t>(sent);
+                    continue;
+                }
+#endif
+                if (errno == EINTR) continue;
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? WriteStatus::BLOCKED
+                                                                 : WriteStatus::FAILED;
+            }
+            return WriteStatus::DONE;
+        }
+
+        // Skip fully written iovecs and trim the partially written one
+        static void advance(iovec*& iov, size_t& count, size_t written) {
+            while (count > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
+
+        static std::vector<Piece>& piece_buffer() {
+            thread_local std::vector<Piece> pieces;
+            return pieces;
+        }
+    };
+
+} // namespace CORE
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "http.hpp"
+#include "../utils/perfect_hash.hpp"
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+namespace CORE {
+
+    // One route known at build time. `Path` names a constexpr char array,
+    // which C++17 accepts as a template argument where a literal is not:
+    //
+    //   inline constexpr char HELLO_PATH[] = "/hello";
+    //   using HelloRoute = CORE::Route<CORE::Method::GET, HELLO_PATH, HelloController>;
+    template <Method M, const char* Path, typename C>
+    struct Route {
+        static constexpr Method method = M;
+        static constexpr std::string_view path = Path;
+        using controller_type = C;
+    };
+
+    // RouteTable dispatches a fixed set of exact routes without any runtime
+    // setup. The distinct paths go into a PerfectHashMap built by the
+    // compiler; a lookup is one hash and one compare, then the matching
+    // (slot, method) pair selects the handler from a fold the compiler
+    // lowers to a few integer compares. Each route owns a default-built
+    // controller of its exact type, and handle() is called by its
+    // qualified name, so the call is direct and can be inlined. Controller
+    // types need a handle(const Request&, Response&) but need not derive
+    // from Controller.
+    //
+    // Plug a table into a Router with Router::use_table<Table>(); its
+    // routes are tried before the runtime ones.
+    template <typename... Routes>
+    class RouteTable {
+    public:
+        static bool route(Request& req, Response& res) {
+            size_t slot = find(req.path);
+            if (slot == PATHS.npos) return false;
+            Method method = req.method_id != Method::UNKNOWN ? req.method_id : parse_method(req.method);
+            return dispatch(slot, method, req, res, std::index_sequence_for<Routes...>{});
+        }
+
+        static bool has_route(Method method, std::string_view path) {
+            size_t slot = find(path);
+            if (slot == PATHS.npos) return false;
+            size_t index = 0;
+            return ((ROUTE_SLOTS[index++] == slot && Routes::method == method) || ...);
+        }
+
+        // The controller instance serving route R
+        template <typename R>
+        static typename R::controller_type& controller() {
+            static typename R::controller_type instance;
+            return instance;
+        }
+
+    private:
+        static constexpr size_t ROUTE_COUNT = sizeof...(Routes);
+        static constexpr std::array<std::string_view, ROUTE_COUNT> ROUTE_PATHS {Routes::path...};
+
+        static constexpr size_t count_distinct() {
+            size_t distinct = 0;
+            for (size_t i = 0; i < ROUTE_COUNT; ++i) {
+                bool seen = false;
+                for (size_t j = 0; j < i; ++j) seen = seen || ROUTE_PATHS[j] == ROUTE_PATHS[i];
+                if (!seen) ++distinct;
+            }
+            return distinct;
+        }
+        static constexpr size_t PATH_COUNT = count_distinct();
+
+        static constexpr std::array<std::string_view, PATH_COUNT> distinct_paths() {
+            std::array<std::string_view, PATH_COUNT> paths {};
+            size_t count = 0;
+            for (size_t i = 0; i < ROUTE_COUNT; ++i) {
+                bool seen = false;
+                for (size_t j = 0; j < count; ++j) seen = seen || paths[j] == ROUTE_PATHS[i];
+                if (!seen) paths[count++] = ROUTE_PATHS[i];
+            }
+            return paths;
+        }
+
+        // Power of two at least 4x the key count, as PerfectHashMap advises
+        static constexpr size_t table_size() {
+            size_t size = 8;
+            while (size < PATH_COUNT * 4) size <<= 1;
+            return size;
+        }
+
+        static constexpr UTILS::PerfectHashMap<PATH_COUNT, table_size(), false> PATHS {distinct_paths()};
+
+        // Slot of each route's path in PATHS, in declaration order
+        static constexpr std::array<size_t, ROUTE_COUNT> route_slots() {
+            std::array<size_t, ROUTE_COUNT> slots {};
+            for (size_t i = 0; i < ROUTE_COUNT; ++i) slots[i] = PATHS.find(ROUTE_PATHS[i]);
+            return slots;
+        }
+        static constexpr std::array<size_t, ROUTE_COUNT> ROUTE_SLOTS = route_slots();
+
+        static size_t find(std::string_view path) {
+            return PATHS.find(path.substr(0, path.find('?')));
+        }
+
+        template <typename R>
+        static bool invoke(Request& req, Response& res) {
+            using C = typename R::controller_type;
+            controller<R>().C::handle(req, res);
+            return true;
+        }
+
+        template <size_t... I>
+        static bool dispatch(size_t slot, Method method, Request& req, Response& res,
+                             std::index_sequence<I...>) {
+            return ((ROUTE_SLOTS[I] == slot && Routes::method == method && invoke<Routes>(req, res)) || ...);
+        }
+    };
+
+} // namespace CORE
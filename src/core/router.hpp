@@ -1,89 +1,595 @@
 #pragma once
 
 #include "controller.hpp"
+#include "middleware.hpp"
+#include "response_cache.hpp"
+#include "../utils/single_flight.hpp"
+#include "../utils/xxhash64.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
-#include <memory>
-#include <regex>
 
 namespace CORE {
 
-    struct RouteKey {
-        std::string method;
-        std::string path;
-        
-        bool operator==(const RouteKey& other) const {
-            return method == other.method && path == other.path;
-        }
-    };
+    // RouteSnapshot is one version of the routing configuration, published
+    // by Router (below). Routes live in a compressed radix tree over route
+    // paths. A pattern is
+    // static text plus, at segment starts, two kinds of capture:
+    //
+    //   /users/:id/posts    ":id" matches one non-empty segment
+    //   /assets/*path       "*path" matches the rest of the path, even empty
+    //
+    // When several routes could match, static text wins over a parameter,
+    // and a parameter wins over a wildcard, so "/users/me" beats
+    // "/users/:id" whatever order they were added in. Lookup walks the
+    // path once (backtracking only when a more specific branch dead-ends)
+    // and allocates nothing: captures land in Request::route_params as
+    // offsets into the path. The query string is not part of the match.
+    //
+    // Fully static patterns are also kept in a hash index keyed by path
+    // view, so the common case is one hashed probe with no tree walk.
+    // Handlers are indexed by Method, never by comparing method strings.
+    //
+    // A snapshot also holds what runs around routes: the middleware chain
+    // and the response cache policies of routes opted in with cache_route().
+    class RouteSnapshot {
+    public:
+        RouteSnapshot() = default;
 
-    // Custom hash for RouteKey
-    struct RouteKeyHash {
-        std::size_t operator()(const RouteKey& k) const {
-            return std::hash<std::string>{}(k.method) ^ 
-                   (std::hash<std::string>{}(k.path) << 1);
+        // Deep copy, for the router to edit while readers keep this one
+        RouteSnapshot(const RouteSnapshot& other)
+            : exact_(other.exact_), middleware_(other.middleware_), caching_(other.caching_),
+              table_route_(other.table_route_), table_has_route_(other.table_has_route_) {
+            std::unordered_map<const Node*, const Node*> copies;
+            copy_tree(other.root_, root_, copies);
+            exact_.repoint(copies);
         }
-    };
 
-    // For pattern routes that need regex (use sparingly)
-    struct PatternRoute {
-        std::string method;
-        std::regex path_regex;
-        std::shared_ptr<Controller> controller;
-    };
+        RouteSnapshot& operator=(const RouteSnapshot&) = delete;
 
-    class Router {
-    public:
-        // Add exact route (fast O(1) lookup)
-        void add_route(const std::string& method, const std::string& path, 
+        // Add a route; throws std::logic_error for a malformed pattern or
+        // one whose parameter names conflict with an existing route
+        void add_route(const std::string& method, const std::string& path,
                       std::shared_ptr<Controller> ctrl) {
-            RouteKey key{method, path};
-            exact_routes[key] = std::move(ctrl);
-        }
-        
-        // Add pattern route (slower regex matching, use for wildcards only)
-        void add_pattern_route(const std::string& method, const std::string& path_pattern, 
-                              std::shared_ptr<Controller> ctrl) {
-            pattern_routes.emplace_back(PatternRoute{method, std::regex(path_pattern), std::move(ctrl)});
-        }
-
-        bool route(const Request& req, Response& res) const {
-            // First try exact match (O(1))
-            RouteKey key{req.method, req.path};
-            auto exact_it = exact_routes.find(key);
-            if (exact_it != exact_routes.end()) {
-                exact_it->second->handle(req, res);
+            Method method_id = parse_method(method);
+            if (method_id == Method::UNKNOWN) {
+                throw std::logic_error("Router: unknown method " + method);
+            }
+            insert(path)->handlers[static_cast<size_t>(method_id)] = std::move(ctrl);
+        }
+
+        // Route everything under `prefix` (and `prefix` itself) to `ctrl`.
+        // The part after the prefix is captured as "*".
+        void add_mount(const std::string& method, std::string prefix,
+                       std::shared_ptr<Controller> ctrl) {
+            while (!prefix.empty() && prefix.back() == '/') prefix.pop_back();
+            add_route(method, prefix.empty() ? "/" : prefix, ctrl);
+            add_route(method, prefix + "/*", std::move(ctrl));
+        }
+
+        // Stop routing `method` requests for `path` (as given to add_route);
+        // nothing happens if no such route was added
+        void remove_route(const std::string& method, const std::string& path) {
+            Method method_id = parse_method(method);
+            if (method_id == Method::UNKNOWN) {
+                throw std::logic_error("Router: unknown method " + method);
+            }
+            if (Node* node = find_node(path)) {
+                node->handlers[static_cast<size_t>(method_id)] = nullptr;
+            }
+        }
+
+        // Cache GET responses for paths matching `path` (a route pattern,
+        // which may be served by a RouteTable as well as by add_route)
+        void cache_route(const std::string& path, CachePolicy policy) {
+            insert(path)->cache_policy = std::make_shared<const CachePolicy>(std::move(policy));
+            caching_ = true;
+        }
+
+        // Policy for a GET of `path`, or null if it is not cached
+        std::shared_ptr<const CachePolicy> cache_policy(std::string_view path) const {
+            if (!caching_) return nullptr;
+            RouteParams params;
+            const auto* policy = match(path, params, [](const Node& node) {
+                return node.cache_policy ? &node.cache_policy : nullptr;
+            });
+            return policy ? *policy : nullptr;
+        }
+
+        bool caching() const { return caching_; }
+
+        // Serve the routes of a compile-time RouteTable (route_table.hpp)
+        // ahead of the tree. Only one table can be in use.
+        template <typename Table>
+        void use_table() {
+            table_route_ = &Table::route;
+            table_has_route_ = &Table::has_route;
+        }
+
+        // Run `middleware` around every request, after those already added
+        template <typename M>
+        void use(std::shared_ptr<M> middleware) {
+            middleware_.add(std::move(middleware));
+        }
+
+        const MiddlewareChain& middleware() const { return middleware_; }
+
+        bool route(Request& req, Response& res) const {
+            if (table_route_ && table_route_(req, res)) {
+                return true;
+            }
+            Method method = req.method_id != Method::UNKNOWN ? req.method_id : parse_method(req.method);
+            const std::shared_ptr<Controller>* controller = match_handler(method, req.path, req.route_params);
+            if (!controller) {
+                return false;
+            }
+            (*controller)->handle(req, res);
+            return true;
+        }
+
+        // Resolve a route without dispatching it. The reactor uses this to
+        // answer Expect: 100-continue from the headers alone.
+        bool has_route(const std::string& method, const std::string& path) const {
+            Method method_id = parse_method(method);
+            if (table_has_route_ && table_has_route_(method_id, path)) {
                 return true;
             }
+            RouteParams params;
+            return match_handler(method_id, path, params) != nullptr;
+        }
+
+        // Layout of the index over fully static patterns: how many slots a
+        // lookup of each indexed path probes shows how well XXH64 spreads
+        // the route set. For tests and diagnostics.
+        struct IndexStats {
+            size_t entries = 0;
+            size_t slots = 0;
+            double average_probe = 0;
+            size_t longest_probe = 0;
+            size_t unreachable = 0;  // Indexed paths a lookup would not find; always 0
+        };
+
+        IndexStats index_stats() const { return exact_.stats(); }
+
+    private:
+        struct Node {
+            std::string prefix;                          // Static text on the edge into this node
+            std::string first_bytes;                     // first_bytes[i] == children[i]->prefix[0]
+            std::vector<std::unique_ptr<Node>> children; // Static continuations
+            std::unique_ptr<Node> param;                 // ":name" segment
+            std::unique_ptr<Node> wildcard;              // "*name" rest of path
+            std::string name;                            // Capture name, for param/wildcard nodes
+            std::shared_ptr<Controller> handlers[METHOD_COUNT]; // By Method
+            std::shared_ptr<const CachePolicy> cache_policy;    // For GET, if cached
+        };
+
+        // Copy the tree under `from` into `to`, noting where each node went
+        static void copy_tree(const Node& from, Node& to,
+                              std::unordered_map<const Node*, const Node*>& copies) {
+            to.prefix = from.prefix;
+            to.first_bytes = from.first_bytes;
+            to.name = from.name;
+            std::copy(std::begin(from.handlers), std::end(from.handlers), std::begin(to.handlers));
+            to.cache_policy = from.cache_policy;
+            for (const auto& child : from.children) {
+                to.children.push_back(std::make_unique<Node>());
+                copy_tree(*child, *to.children.back(), copies);
+            }
+            if (from.param) {
+                to.param = std::make_unique<Node>();
+                copy_tree(*from.param, *to.param, copies);
+            }
+            if (from.wildcard) {
+                to.wildcard = std::make_unique<Node>();
+                copy_tree(*from.wildcard, *to.wildcard, copies);
+            }
+            copies[&from] = &to;
+        }
+
+        // Node for `path`, creating it and any captures on the way
+        Node* insert(const std::string& path) {
+            // Matching records at most MAX_PARAMS captures, so a pattern with
+            // more would be accepted here and then never match
+            size_t captures = 0;
+            for (size_t i = 1; i < path.size(); ++i) {
+                if ((path[i] == ':' || path[i] == '*') && path[i - 1] == '/') ++captures;
+            }
+            if (captures > RouteParams::MAX_PARAMS) {
+                throw std::logic_error("Router: " + path + " has more than " +
+                                       std::to_string(RouteParams::MAX_PARAMS) + " captures");
+            }
+
+            Node* node = &root_;
+            std::string_view rest = path;
+            while (!rest.empty()) {
+                size_t capture = next_capture(rest);
+                node = insert_static(node, rest.substr(0, capture));
+                rest.remove_prefix(capture);
+                if (rest.empty()) break;
+
+                size_t end = rest[0] == '*' ? rest.size() : std::min(rest.find('/'), rest.size());
+                std::string name(rest.substr(1, end - 1));
+                if ((rest[0] == ':' && name.empty()) || name.find('/') != std::string::npos) {
+                    throw std::logic_error("Router: malformed capture in " + path);
+                }
+                std::unique_ptr<Node>& child = rest[0] == ':' ? node->param : node->wildcard;
+                if (!child) {
+                    child = std::make_unique<Node>();
+                    child->name = name.empty() ? "*" : name;
+                } else if (child->name != (name.empty() ? "*" : name)) {
+                    throw std::logic_error("Router: " + path + " renames capture '" + child->name + "'");
+                }
+                node = child.get();
+                rest.remove_prefix(end);
+            }
+
+            if (next_capture(path) == path.size()) {
+                exact_.insert(path, node);
+            }
+            return node;
+        }
+
+        // Node that insert() would return for `path`, without creating
+        // anything; null if there is none or a capture is named differently
+        Node* find_node(std::string_view path) {
+            Node* node = &root_;
+            std::string_view rest = path;
+            while (!rest.empty()) {
+                size_t capture = next_capture(rest);
+                node = find_static(node, rest.substr(0, capture));
+                if (!node) return nullptr;
+                rest.remove_prefix(capture);
+                if (rest.empty()) break;
+
+                size_t end = rest[0] == '*' ? rest.size() : std::min(rest.find('/'), rest.size());
+                std::string_view name = rest.substr(1, end - 1);
+                Node* child = rest[0] == ':' ? node->param.get() : node->wildcard.get();
+                if (!child || child->name != (name.empty() ? std::string_view("*") : name)) {
+                    return nullptr;
+                }
+                node = child;
+                rest.remove_prefix(end);
+            }
+            return node;
+        }
+
+        // Follow the static edges spelling exactly `text`; null if they
+        // do not end on a node
+        static Node* find_static(Node* node, std::string_view text) {
+            while (!text.empty()) {
+                size_t index = node->first_bytes.find(text[0]);
+                if (index == std::string::npos) return nullptr;
+                Node* child = node->children[index].get();
+                if (text.compare(0, child->prefix.size(), child->prefix) != 0) {
+                    return nullptr; // Differs, or `text` ends partway along the edge
+                }
+                node = child;
+                text.remove_prefix(child->prefix.size());
+            }
+            return node;
+        }
+
+        // Open addressing with linear probing, at most half full, over
+        // XXH64 of the path. The full hash is kept per slot so a probe
+        // compares strings only on a 64-bit match.
+        class ExactIndex {
+        public:
+            void insert(std::string_view path, const Node* node) {
+                if ((count_ + 1) * 2 > slots_.size()) {
+                    grow();
+                }
+                uint64_t hash = UTILS::XXHash64::hash(path);
+                Slot& slot = probe(hash, path);
+                if (!slot.node) ++count_;
+                slot = Slot{hash, std::string(path), node};
+            }
             
-            // Fall back to pattern matching (O(n))
-            for (const auto& pattern_route : pattern_routes) {
-                if (pattern_route.method == req.method && 
-                    std::regex_match(req.path, pattern_route.path_regex)) {
-                    pattern_route.controller->handle(req, res);
-                    return true;
+            // Point slots at the copies of the nodes they pointed at
+            void repoint(const std::unordered_map<const Node*, const Node*>& copies) {
+                for (Slot& slot : slots_) {
+                    if (slot.node) slot.node = copies.at(slot.node);
                 }
             }
             
-            return false;
+            const Node* find(std::string_view path) const {
+                if (slots_.empty()) return nullptr;
+                uint64_t hash = UTILS::XXHash64::hash(path);
+                size_t mask = slots_.size() - 1;
+                for (size_t i = hash & mask; slots_[i].node; i = (i + 1) & mask) {
+                    if (slots_[i].hash == hash && slots_[i].path == path) {
+                        return slots_[i].node;
+                    }
+                }
+                return nullptr;
+            }
+            
+            IndexStats stats() const {
+                IndexStats result;
+                result.entries = count_;
+                result.slots = slots_.size();
+                size_t mask = slots_.size() - 1;
+                size_t total = 0;
+                for (const Slot& slot : slots_) {
+                    if (!slot.node) continue;
+                    if (find(slot.path) != slot.node) ++result.unreachable;
+                    size_t probes = 1;
+                    for (size_t i = slot.hash & mask; &slots_[i] != &slot; i = (i + 1) & mask) {
+                        ++probes;
+                    }
+                    total += probes;
+                    result.longest_probe = std::max(result.longest_probe, probes);
+                }
+                result.average_probe = count_ ? static_cast<double>(total) / count_ : 0;
+                return result;
+            }
+            
+        private:
+            struct Slot {
+                uint64_t hash = 0;
+                std::string path;
+                const Node* node = nullptr;
+            };
+            
+            std::vector<Slot> slots_;
+            size_t count_ = 0;
+            
+            Slot& probe(uint64_t hash, std::string_view path) {
+                size_t mask = slots_.size() - 1;
+                size_t i = hash & mask;
+                while (slots_[i].node && !(slots_[i].hash == hash && slots_[i].path == path)) {
+                    i = (i + 1) & mask;
+                }
+                return slots_[i];
+            }
+            
+            void grow() {
+                std::vector<Slot> old = std::move(slots_);
+                slots_.assign(old.empty() ? 16 : old.size() * 2, Slot{});
+                for (Slot& slot : old) {
+                    if (slot.node) {
+                        Slot& target = probe(slot.hash, slot.path);
+                        target = std::move(slot);
+                    }
+                }
+            }
+        };
+
+        Node root_;
+        ExactIndex exact_;
+        MiddlewareChain middleware_;
+        bool caching_ = false;
+        bool (*table_route_)(Request&, Response&) = nullptr;
+        bool (*table_has_route_)(Method, std::string_view) = nullptr;
+
+        // Offset of the next ':' or '*' that starts a segment
+        static size_t next_capture(std::string_view pattern) {
+            for (size_t i = 0; i < pattern.size(); ++i) {
+                if ((pattern[i] == ':' || pattern[i] == '*') && i > 0 && pattern[i - 1] == '/') {
+                    return i;
+                }
+            }
+            return pattern.size();
+        }
+
+        // Walk or extend the static edges for `text`, splitting an edge
+        // where it and `text` part ways
+        static Node* insert_static(Node* node, std::string_view text) {
+            while (!text.empty()) {
+                size_t index = node->first_bytes.find(text[0]);
+                if (index == std::string::npos) {
+                    auto child = std::make_unique<Node>();
+                    child->prefix = std::string(text);
+                    node->first_bytes += text[0];
+                    node->children.push_back(std::move(child));
+                    return node->children.back().get();
+                }
+
+                std::unique_ptr<Node>& child = node->children[index];
+                size_t common = 0;
+                while (common < text.size() && common < child->prefix.size() &&
+                       text[common] == child->prefix[common]) {
+                    ++common;
+                }
+                if (common < child->prefix.size()) {
+                    auto middle = std::make_unique<Node>();
+                    middle->prefix = child->prefix.substr(0, common);
+                    child->prefix.erase(0, common);
+                    middle->first_bytes += child->prefix[0];
+                    middle->children.push_back(std::move(child));
+                    child = std::move(middle);
+                }
+                node = child.get();
+                text.remove_prefix(common);
+            }
+            return node;
+        }
+
+        const std::shared_ptr<Controller>* match_handler(Method method, std::string_view path,
+                                                         RouteParams& params) const {
+            if (method == Method::UNKNOWN) return nullptr;
+            return match(path, params, [method](const Node& node) {
+                const std::shared_ptr<Controller>& handler = node.handlers[static_cast<size_t>(method)];
+                return handler ? &handler : nullptr;
+            });
+        }
+
+        // Find the most specific node for `path` where `select` (Node ->
+        // pointer, null to keep looking) yields something
+        template <typename Select>
+        auto match(std::string_view path, RouteParams& params, const Select& select) const
+            -> decltype(select(root_)) {
+            params.count = 0;
+            std::string_view target = path.substr(0, path.find('?'));
+            if (const Node* node = exact_.find(target)) {
+                if (auto found = select(*node)) return found;
+            }
+            return match_node(root_, select, target, 0, params);
+        }
+
+        // `node`'s own prefix is consumed; match target[position..]
+        template <typename Select>
+        static auto match_node(const Node& node, const Select& select, std::string_view target,
+                               size_t position, RouteParams& params) -> decltype(select(node)) {
+            if (position == target.size()) {
+                if (auto found = select(node)) return found;
+            } else {
+                // Static text first: at most one child shares the next byte
+                const char* hit = static_cast<const char*>(
+                    std::memchr(node.first_bytes.data(), target[position], node.first_bytes.size()));
+                if (hit) {
+                    const Node& child = *node.children[static_cast<size_t>(hit - node.first_bytes.data())];
+                    if (target.compare(position, child.prefix.size(), child.prefix) == 0) {
+                        if (auto found = match_node(child, select, target, position + child.prefix.size(), params)) {
+                            return found;
+                        }
+                    }
+                }
+
+                // Then a parameter covering the whole next segment
+                if (node.param && params.count < RouteParams::MAX_PARAMS) {
+                    size_t end = std::min(target.find('/', position), target.size());
+                    if (end > position) {
+                        size_t saved = params.count;
+                        params.add(node.param->name, position, end - position);
+                        if (auto found = match_node(*node.param, select, target, end, params)) {
+                            return found;
+                        }
+                        params.count = saved;
+                    }
+                }
+            }
+
+            // Finally a wildcard takes whatever is left
+            if (node.wildcard && params.count < RouteParams::MAX_PARAMS) {
+                if (auto found = select(*node.wildcard)) {
+                    params.add(node.wildcard->name, position, target.size() - position);
+                    return found;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // Router publishes the routing configuration as immutable
+    // RouteSnapshots. Each thread keeps the snapshot it last used and only
+    // checks a version counter to see whether it is still current, so a
+    // reader pays one atomic load: no lock, no reference count. An edit
+    // copies the current snapshot, changes the copy and swaps it in with a
+    // new version, so routes, controllers and middleware can be replaced
+    // while requests are being served. Requests already running finish on
+    // the snapshot they started with; a thread drops its old one (and the
+    // controllers only it still uses) the next time it looks. Until some
+    // thread has looked, edits apply in place, so building the initial
+    // routes costs no copies.
+    //
+    // The router also owns the runtime state kept around routes: the
+    // response cache and the in-flight coalesced requests.
+    class Router {
+    public:
+        Router() : routes_(std::make_shared<RouteSnapshot>()), id_(next_id()) {}
+
+        // The current routes. The reference is to this thread's copy of the
+        // pointer and changes at its next call; take a copy of the
+        // shared_ptr to hold the snapshot beyond that.
+        const std::shared_ptr<const RouteSnapshot>& snapshot() const {
+            thread_local Seen seen;
+            uint64_t version = version_.load(std::memory_order_acquire);
+            if (seen.router != id_ || seen.version != version) {
+                std::lock_guard<std::mutex> lock(write_mutex_);
+                seen.routes = routes_;
+                seen.version = version_.load(std::memory_order_relaxed);
+                seen.router = id_;
+            }
+            return seen.routes;
+        }
+
+        // Apply `edit` (called with a RouteSnapshot&) and publish the result
+        // as a single change. Once the routes are in use, an edit that
+        // throws publishes nothing.
+        template <typename Edit>
+        void update(Edit&& edit) {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            std::shared_ptr<RouteSnapshot> next =
+                routes_.use_count() == 1 ? routes_ : std::make_shared<RouteSnapshot>(*routes_);
+            edit(*next);
+            routes_ = std::move(next);
+            version_.fetch_add(1, std::memory_order_release);
+            cache_.clear(); // Stored responses may be for routes that changed
+        }
+
+        void add_route(const std::string& method, const std::string& path,
+                      std::shared_ptr<Controller> ctrl) {
+            update([&](RouteSnapshot& routes) { routes.add_route(method, path, std::move(ctrl)); });
         }
 
-        // Add some useful utility routes
-        void add_static_file_route(const std::string& prefix, 
-                                 [[maybe_unused]] const std::string& directory) {
-            // TODO: Implement static file serving
-            // For now, just add a pattern route as placeholder
-            // The directory parameter will be used when we implement static serving
-            add_pattern_route("GET", prefix + "/(.*)", nullptr);
+        void add_mount(const std::string& method, const std::string& prefix,
+                       std::shared_ptr<Controller> ctrl) {
+            update([&](RouteSnapshot& routes) { routes.add_mount(method, prefix, std::move(ctrl)); });
         }
 
+        void remove_route(const std::string& method, const std::string& path) {
+            update([&](RouteSnapshot& routes) { routes.remove_route(method, path); });
+        }
+
+        void cache_route(const std::string& path, CachePolicy policy) {
+            update([&](RouteSnapshot& routes) { routes.cache_route(path, std::move(policy)); });
+        }
+
+        template <typename Table>
+        void use_table() {
+            update([](RouteSnapshot& routes) { routes.use_table<Table>(); });
+        }
+
+        template <typename M>
+        void use(std::shared_ptr<M> middleware) {
+            update([&](RouteSnapshot& routes) { routes.use(std::move(middleware)); });
+        }
+
+        // One-off reads against the current snapshot, held for the call in
+        // case a controller looks at the routes again
+        bool route(Request& req, Response& res) const {
+            std::shared_ptr<const RouteSnapshot> routes = snapshot();
+            return routes->route(req, res);
+        }
+        bool has_route(const std::string& method, const std::string& path) const {
+            std::shared_ptr<const RouteSnapshot> routes = snapshot();
+            return routes->has_route(method, path);
+        }
+
+        ResponseCache& response_cache() { return cache_; }
+
+        // Misses of routes cached with `coalesce`, keyed by
+        // ResponseCache::key, waiting on the request that runs the controller
+        UTILS::SingleFlight<CoalescedRequest>& flights() { return flights_; }
+
     private:
-        // Fast exact matches
-        std::unordered_map<RouteKey, std::shared_ptr<Controller>, RouteKeyHash> exact_routes;
-        
-        // Slower pattern matches (use sparingly)
-        std::vector<PatternRoute> pattern_routes;
+        struct Seen {
+            uint64_t router = 0;
+            uint64_t version = 0;
+            std::shared_ptr<const RouteSnapshot> routes;
+        };
+
+        mutable std::mutex write_mutex_;               // Serializes edits and snapshot refreshes
+        std::shared_ptr<RouteSnapshot> routes_;        // Current snapshot, under write_mutex_
+        std::atomic<uint64_t> version_ {1};
+        const uint64_t id_;                            // Tells routers apart in Seen
+        ResponseCache cache_;
+        UTILS::SingleFlight<CoalescedRequest> flights_;
+
+        static uint64_t next_id() {
+            static std::atomic<uint64_t> ids {1};
+            return ids.fetch_add(1, std::memory_order_relaxed);
+        }
     };
 
-} // namespace CORE
\ No newline at end of file
+} // namespace CORE
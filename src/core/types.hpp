@@ -2,9 +2,14 @@
 
 #include <string>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 namespace CORE {
 
+    struct PendingWrite;
+
     // Protocol types supported server
     enum class Protocol { 
         HTTP, 
@@ -21,6 +26,10 @@ namespace CORE {
         std::string http_buffer;                             // Stores partial HTTP requests
         bool http_headers_complete = false;                  // Flag indicating if HTTP headers were fully read
         bool websocket_handshake_complete = false;           // WebSocket handshake status
+        std::mutex write_mutex;                              // Guards the three below
+        std::shared_ptr<PendingWrite> pending_write;         // Response waiting for the socket to drain
+        bool writing = false;                                // A response is partway out, parked or resuming
+        std::deque<std::shared_ptr<PendingWrite>> queued_writes; // Responses waiting their turn behind it
 
         ConnectionState(int fd, const std::string& ip, uint16_t port)
             : socket_fd(fd), client_ip(ip), client_port(port), 
@@ -1,29 +1,137 @@
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
 #include "server/server.hpp"
+#include "core/route_table.hpp"
 #include "controllers/hello_controller.hpp"
 #include "controllers/json_controller.hpp"
 #include "controllers/static_file_controller.hpp"
 #include "controllers/test_body_controller.hpp"
+#include "middleware/auth_middleware.hpp"
+#include "middleware/cors_middleware.hpp"
+#include "middleware/request_id_middleware.hpp"
+#include "middleware/timing_middleware.hpp"
 
-int main() {
+// Routes whose controllers are known at build time: dispatched through a
+// compile-time perfect hash with direct handler calls
+inline constexpr char HELLO_PATH[] = "/hello";
+inline constexpr char STATUS_PATH[] = "/api/status";
+inline constexpr char TEST_BODY_PATH[] = "/test/body";
+
+using ApiRoutes = CORE::RouteTable<
+    CORE::Route<CORE::Method::GET, HELLO_PATH, HelloController>,
+    CORE::Route<CORE::Method::GET, STATUS_PATH, JsonController>,
+    CORE::Route<CORE::Method::POST, TEST_BODY_PATH, TestBodyController>,
+    CORE::Route<CORE::Method::PUT, TEST_BODY_PATH, TestBodyController>>;
+
+// Pack the document root into a bundle (see UTILS::AssetBundle)
+static bool pack_bundle(const std::string& document_root, const std::string& bundle_path) {
+    auto result = UTILS::AssetBundle::pack(document_root, bundle_path);
+    if (!result.success) {
+        std::cerr << "❌ Packing " << document_root << " failed: " << result.error_message << std::endl;
+        return false;
+    }
+    std::cout << "📦 Packed " << result.file_count << " files into " << bundle_path 
+              << " (" << result.bundle_size << " bytes)" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string document_root = "./public";
+    
+    // --pack FILE      pack the document root into FILE and exit (a build step)
+    // --bundle FILE    serve static files from FILE, packing it first if missing
+    // --preload PATH   load PATH (e.g. /index.html) into the caches before accepting
+    // --snapshot FILE  also preload the most-requested files recorded in FILE,
+    //                  and record this run's in it on shutdown
+    // --cors ORIGIN    allow cross-origin requests from ORIGIN ("*" for any)
+    // --auth-token T   require "Authorization: Bearer T" for /api
+    // --trace          tag responses with X-Request-Id and Server-Timing
+    std::string bundle_path;
+    std::string snapshot_path;
+    std::string cors_origin;
+    std::string auth_token;
+    std::vector<std::string> preload_paths;
+    bool trace = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--trace") == 0) {
+            trace = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            break;
+        }
+        if (std::strcmp(argv[i], "--pack") == 0) {
+            return pack_bundle(document_root, argv[i + 1]) ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--bundle") == 0) {
+            bundle_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--preload") == 0) {
+            preload_paths.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--snapshot") == 0) {
+            snapshot_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--cors") == 0) {
+            cors_origin = argv[++i];
+        } else if (std::strcmp(argv[i], "--auth-token") == 0) {
+            auth_token = argv[++i];
+        } else {
+            ++i;
+        }
+    }
+    
+    struct stat bundle_stat;
+    if (!bundle_path.empty() && stat(bundle_path.c_str(), &bundle_stat) != 0 &&
+        !pack_bundle(document_root, bundle_path)) {
+        return 1;
+    }
+    
     try {
         // Create server on port 8080 with 10 worker threads
         SERVER::Server server(8080, 10);
         
         // Configure static file serving
-        std::string document_root = "./public";
-        auto static_controller = std::make_shared<StaticFileController>(document_root);
+        auto static_controller = std::make_shared<StaticFileController>(document_root, bundle_path);
+        
+        // Warm the caches before the first connection is accepted
+        if (!snapshot_path.empty()) {
+            auto recorded = StaticFileController::load_snapshot(snapshot_path);
+            preload_paths.insert(preload_paths.end(), recorded.begin(), recorded.end());
+        }
+        if (!preload_paths.empty()) {
+            auto started = std::chrono::steady_clock::now();
+            size_t loaded = static_controller->warm_up(preload_paths);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started);
+            std::cout << "🔥 Preloaded " << loaded << " of " << preload_paths.size() 
+                      << " files in " << elapsed.count() << "ms" << std::endl;
+        }
+        
+        // Middleware, outermost first
+        if (trace) {
+            server.use(std::make_shared<RequestIdMiddleware>());
+            server.use(std::make_shared<TimingMiddleware>());
+        }
+        if (!cors_origin.empty()) {
+            server.use(std::make_shared<CorsMiddleware>(cors_origin));
+        }
+        if (!auth_token.empty()) {
+            server.use(std::make_shared<BearerAuthMiddleware>(auth_token, "/api"));
+        }
         
         // Add API routes (these get checked first)
-        server.add_route("GET", "/hello", std::make_shared<HelloController>());
-        server.add_route("GET", "/api/status", std::make_shared<JsonController>());
+        server.use_route_table<ApiRoutes>();
+        
+        // Status is cheap to go a second out of date: reuse it for a
+        // second, and serve it stale for five more while it is rebuilt.
+        // Concurrent misses share a single controller run.
+        server.cache_route("/api/status", {std::chrono::milliseconds(1000),
+                                           std::chrono::milliseconds(5000), {}, true});
         
         // Add static file routes
         server.add_route("GET", "/", static_controller);
         server.add_route("GET", "/index.html", static_controller);
-        
-        server.add_route("POST", "/test/body", std::make_shared<TestBodyController>());
-        server.add_route("PUT", "/test/body", std::make_shared<TestBodyController>());
 
         // Enable performance features
         server.set_keep_alive(true);
@@ -34,7 +142,8 @@ int main() {
         std::cout << "Port: 8080" << std::endl;
         std::cout << "Workers: 10" << std::endl;
         std::cout << "Keep-alive: ENABLED" << std::endl;
-        std::cout << "Static files: " << document_root << std::endl;
+        std::cout << "Static files: " << document_root 
+                  << (bundle_path.empty() ? "" : " (bundle: " + bundle_path + ")") << std::endl;
         std::cout << "=================================" << std::endl;
         std::cout << "🌐 Visit http://localhost:8080/" << std::endl;
         std::cout << "🔧 API: http://localhost:8080/api/status" << std::endl;
@@ -44,6 +153,10 @@ int main() {
         // Start server (blocking call)
         server.start();
         
+        if (!snapshot_path.empty() && !static_controller->save_snapshot(snapshot_path)) {
+            std::cerr << "⚠️  Could not write cache snapshot " << snapshot_path << std::endl;
+        }
+        
     } catch (const std::exception& e) {
         std::cerr << "❌ Server error: " << e.what() << std::endl;
         return 1;
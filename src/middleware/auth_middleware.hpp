@@ -0,0 +1,43 @@
+#pragma once
+#include "../core/http.hpp"
+#include "../core/prebuilt_responses.hpp"
+#include <string>
+
+// Requires "Authorization: Bearer <token>" for every path under `prefix`,
+// answering 401 otherwise. Add it after CorsMiddleware so preflights, which
+// carry no credentials, are answered first.
+class BearerAuthMiddleware {
+public:
+    BearerAuthMiddleware(std::string token, std::string prefix = "/")
+        : expected_("Bearer " + std::move(token)), prefix_(std::move(prefix)) {}
+
+    bool before(CORE::Request& req, CORE::Response& res) {
+        if (req.path.compare(0, prefix_.size(), prefix_) != 0 ||
+            matches(req.headers.get("Authorization"))) {
+            return true;
+        }
+
+        res.status_code = 401;
+        res.status_text = "Unauthorized";
+        res.headers.set(CORE::HeaderId::CONTENT_TYPE, "text/html");
+        res.headers.set("WWW-Authenticate", "Bearer");
+        res.shared_body = CORE::PrebuiltErrorResponse::page(401);
+        return false;
+    }
+
+    void after(const CORE::Request&, CORE::Response&) {}
+
+private:
+    std::string expected_;
+    std::string prefix_;
+
+    // Compares every byte whatever the input, so timing leaks nothing
+    // about how much of the token was right
+    bool matches(std::string_view given) const {
+        unsigned char diff = given.size() != expected_.size();
+        for (size_t i = 0; i < expected_.size(); ++i) {
+            diff |= static_cast<unsigned char>(expected_[i] ^ (i < given.size() ? given[i] : 0));
+        }
+        return diff == 0;
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "../core/http.hpp"
+#include <string>
+
+// Cross-origin access for browsers. Requests from `origin` (or from any
+// origin with "*") get Access-Control-Allow-Origin; preflight OPTIONS
+// requests are answered here with 204 and never reach a route.
+class CorsMiddleware {
+public:
+    explicit CorsMiddleware(std::string origin = "*",
+                            std::string methods = "GET, POST, PUT, DELETE, OPTIONS")
+        : origin_(std::move(origin)), methods_(std::move(methods)) {}
+
+    bool before(CORE::Request& req, CORE::Response& res) {
+        if (req.method_id != CORE::Method::OPTIONS ||
+            req.headers.get("Access-Control-Request-Method").empty() ||
+            !allowed(req.headers.get("Origin"))) {
+            return true;
+        }
+
+        res.status_code = 204;
+        res.status_text = "No Content";
+        allow(res);
+        res.headers.set("Access-Control-Allow-Methods", methods_);
+        std::string_view headers = req.headers.get("Access-Control-Request-Headers");
+        if (!headers.empty()) {
+            res.headers.set("Access-Control-Allow-Headers", headers);
+        }
+        res.headers.set("Access-Control-Max-Age", "600");
+        return false;
+    }
+
+    void after(const CORE::Request& req, CORE::Response& res) {
+        if (allowed(req.headers.get("Origin"))) {
+            allow(res);
+        }
+    }
+
+private:
+    std::string origin_;
+    std::string methods_;
+
+    bool allowed(std::string_view origin) const {
+        return !origin.empty() && (origin_ == "*" || origin == origin_);
+    }
+
+    void allow(CORE::Response& res) const {
+        res.headers.set("Access-Control-Allow-Origin", origin_);
+        if (origin_ == "*") return;
+
+        // The answer depends on Origin, so caches must key on it too
+        std::string_view vary = res.headers.get(CORE::HeaderId::VARY);
+        if (vary.empty()) {
+            res.headers.set(CORE::HeaderId::VARY, "Origin");
+        } else if (vary.find("Origin") == std::string_view::npos) {
+            res.headers.set(CORE::HeaderId::VARY, std::string(vary) + ", Origin");
+        }
+    }
+};
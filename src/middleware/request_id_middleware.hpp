@@ -0,0 +1,54 @@
+#pragma once
+#include "../core/http.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Gives every request an X-Request-Id and echoes it on the response. A
+// well-formed id from the client (or a proxy in front of us) is kept;
+// otherwise one is minted from a per-process prefix and a counter.
+class RequestIdMiddleware {
+public:
+    RequestIdMiddleware()
+        : prefix_(static_cast<uint32_t>(
+              std::chrono::system_clock::now().time_since_epoch().count())) {}
+
+    bool before(CORE::Request& req, CORE::Response&) {
+        if (!acceptable(req.headers.get(HEADER))) {
+            char id[16];
+            to_hex(id, prefix_, 8);
+            to_hex(id + 8, next_.fetch_add(1, std::memory_order_relaxed), 8);
+            req.headers.set(HEADER, std::string_view(id, sizeof(id)));
+        }
+        return true;
+    }
+
+    void after(const CORE::Request& req, CORE::Response& res) {
+        res.headers.set(HEADER, req.headers.get(HEADER));
+    }
+
+private:
+    static constexpr std::string_view HEADER = "X-Request-Id";
+    static constexpr size_t MAX_LENGTH = 64;
+
+    uint32_t prefix_;
+    std::atomic<uint32_t> next_ {0};
+
+    // Short and limited to characters that are safe to log and echo
+    static bool acceptable(std::string_view id) {
+        if (id.empty() || id.size() > MAX_LENGTH) return false;
+        for (char c : id) {
+            bool ok = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      c == '-' || c == '_' || c == '.' || c == ':';
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    static void to_hex(char* out, uint32_t value, int digits) {
+        static constexpr char HEX[] = "0123456789abcdef";
+        for (int i = digits - 1; i >= 0; --i, value >>= 4) {
+            out[i] = HEX[value & 0xf];
+        }
+    }
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include "../core/http.hpp"
+#include <charconv>
+#include <chrono>
+
+// Reports how long the server spent producing the response, from the
+// worker picking the request up to the body being ready (disk work
+// included), as a Server-Timing header: "app;dur=0.042" in milliseconds
+class TimingMiddleware {
+public:
+    bool before(CORE::Request&, CORE::Response&) {
+        return true;
+    }
+
+    void after(const CORE::Request& req, CORE::Response& res) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - req.started).count();
+
+        char value[48] = "app;dur=";
+        char* end = std::to_chars(value + 8, value + sizeof(value) - 4, micros / 1000).ptr;
+        *end++ = '.';
+        *end++ = static_cast<char>('0' + micros / 100 % 10);
+        *end++ = static_cast<char>('0' + micros / 10 % 10);
+        *end++ = static_cast<char>('0' + micros % 10);
+        res.headers.set("Server-Timing", std::string_view(value, end - value));
+    }
+};
@@ -1,5 +1,6 @@
 #include "event_loop.hpp"
 #include "../core/http_request_task.hpp"
+#include "../core/response_writer.hpp"
 #include "../core/logger.hpp"
 
 #include <iostream>
@@ -9,6 +10,7 @@
 #include <fcntl.h>      // For file control shit
 #include <arpa/inet.h>  // For sockaddr_in and stuff 
 #include <errno.h>      // For errno checking error types
+#include <cstring>      // For strerror
 #include <thread>
 #include <chrono>
 
@@ -27,8 +29,8 @@ namespace REACTOR {
         return fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK);
     }
 
-    EventLoop::EventLoop(EXECUTOR::ThreadPool& threadpool, CORE::Router& r) 
-        : thread_pool(&threadpool), router(r) {
+    EventLoop::EventLoop(EXECUTOR::ThreadPool& threadpool, EXECUTOR::ThreadPool& iopool, CORE::Router& r) 
+        : thread_pool(&threadpool), io_pool(&iopool), router(r) {
         this->notifier = std::make_unique<EventNotifier>();
         
         // Start cleanup thread for connection management
@@ -112,6 +114,10 @@ namespace REACTOR {
                 (keep_alive_enabled.load() ? "enabled" : "disabled"));
         while (!should_stop.load()) {
             auto events = notifier->wait_for_events(1000); // 1 second timeout
+            
+            // Refresh the cached Date header before any of these events
+            // turns into a response
+            UTILS::HttpDateClock::tick();
             for (const auto& event : events) {
                 handle_event(event);
             }
@@ -158,8 +164,9 @@ namespace REACTOR {
                 continue;
             }
 
-            // Add to event notifier
-            if (!notifier->add_fd(client_fd)) {
+            // Add to event notifier; writability resumes responses parked
+            // on a full socket buffer
+            if (!notifier->add_fd(client_fd, EVENT_READ | EVENT_WRITE)) {
                 LOG_ERROR("Failed to add client socket to event notifier");
                 close(client_fd);
                 continue;
@@ -183,6 +190,10 @@ namespace REACTOR {
     }
 
     void EventLoop::handle_client_event(int fd, uint32_t events) {
+        if (events & FLAG_WRITE) {
+            resume_pending_write(fd);
+        }
+
         if (events & FLAG_READ) {
             // Use thread-safe connection handle
             auto conn_handle = connection_manager.get_connection_handle(fd);
@@ -206,7 +217,7 @@ namespace REACTOR {
                     // Check request size limit - this modifies connection data
                     if (!connection_manager.check_request_size_limit(fd, n)) {
                         LOG_WARN("Request size limit exceeded for fd:", fd);
-                        send_error_response(fd, 413, "Request Entity Too Large");
+                        send_error_response(fd, 413);
                         should_disconnect = true;
                         break;
                     }
@@ -223,9 +234,14 @@ namespace REACTOR {
                         LOG_DEBUG("Complete HTTP request received from fd:", fd, 
                                 request.method, request.path);
                         
+                        if (serve_from_cache(conn, request)) {
+                            connection_manager.reset_parser(fd);
+                            return;
+                        }
+                        
                         // Pass keep-alive setting to task
                         auto task = std::make_unique<CORE::HTTPRequestTask>(
-                            request, conn, router, keep_alive_enabled.load()
+                            std::move(request), conn, router, keep_alive_enabled.load(), io_pool, thread_pool
                         );
                         thread_pool->enqueue_task(std::move(task));
                         
@@ -241,11 +257,19 @@ namespace REACTOR {
                         return;
                         
                     } else if (parser->has_error()) {
-                        // Parsing error - send 400 Bad Request
+                        // Parsing error - 400 Bad Request, or 413/417 where more specific
                         LOG_WARN("HTTP parsing error for fd:", fd, "-", parser->get_error_description());
-                        send_error_response(fd, 400, "Bad Request");
+                        send_error_response(fd, parser->get_error_status());
                         should_disconnect = true;
                         break;
+                    } else if (parser->awaiting_body_decision()) {
+                        // Headers are in but the body is not: reject it now
+                        // instead of after buffering it
+                        parser->mark_body_decided();
+                        if (!admit_request_body(fd, parser)) {
+                            should_disconnect = true;
+                            break;
+                        }
                     }
                     // else: partial request, continue reading
                     
@@ -279,6 +303,45 @@ namespace REACTOR {
         }
     }
 
+    void EventLoop::resume_pending_write(int fd) {
+        auto conn_handle = connection_manager.get_connection_handle(fd);
+        if (!conn_handle.is_valid()) {
+            return;
+        }
+
+        auto conn = conn_handle.connection();
+        std::shared_ptr<CORE::PendingWrite> pending;
+        {
+            std::lock_guard<std::mutex> lock(conn->write_mutex);
+            pending = std::move(conn->pending_write);
+        }
+        if (pending) {
+            thread_pool->enqueue_task(std::make_unique<CORE::ResumeWriteTask>(conn, std::move(pending)));
+        }
+    }
+
+    bool EventLoop::serve_from_cache(const std::shared_ptr<CORE::ConnectionState>& conn,
+                                     CORE::Request& request) {
+        // The stored head is the whole response but for Date and Age, so it
+        // can only be used when no middleware runs around it and it is meant
+        // to keep the connection open, as the head says
+        std::shared_ptr<const CORE::RouteSnapshot> routes = router.snapshot();
+        if (!routes->caching() || !routes->middleware().empty() || !keep_alive_enabled.load() ||
+            request.version != "HTTP/1.1" ||
+            CORE::iequals(request.headers.get(CORE::HeaderId::CONNECTION), "close")) {
+            return false;
+        }
+        auto cached = router.response_cache().find(request);
+        if (!cached.entry) {
+            return false;
+        }
+        CORE::HTTPRequestTask::send_cached(conn, *cached.entry, -1);
+        if (cached.refresh) {
+            CORE::HTTPRequestTask::refresh_cached(router, routes, std::move(request), std::move(cached.entry), io_pool);
+        }
+        return true;
+    }
+
     void EventLoop::close_connection(int fd) {
         // This gets called by worker threads when they want to close a connection
         // (either because keep-alive is disabled or there was an error)
@@ -286,34 +349,43 @@ namespace REACTOR {
         handle_client_disconnect(fd);
     }
 
-    void EventLoop::send_error_response(int fd, int status_code, const std::string& status_text) {
-        CORE::Response response;
-        response.status_code = status_code;
-        response.status_text = status_text;
-        response.headers["Content-Type"] = "text/html";
-        response.headers["Connection"] = "close";
-        response.headers["Server"] = "see-plus-plus/1.0";
+    void EventLoop::send_error_response(int fd, int status_code) {
+        // Status line, headers and HTML page are prebuilt; only Date varies.
+        // One non-blocking send: every caller closes the connection next,
+        // and whatever the socket did not take is dropped with it.
+        const auto& prebuilt = CORE::PrebuiltErrorResponse::get(status_code);
+        if (!CORE::ResponseWriter::write(fd, prebuilt)) {
+            LOG_ERROR("Failed to send error response to fd:", fd, "-", strerror(errno));
+        }
+    }
+
+    bool EventLoop::admit_request_body(int fd, CORE::HTTPParser* parser) {
+        const CORE::Request& pending = parser->pending_request();
         
-        // Create a proper HTML error page
-        response.body = R"(<!DOCTYPE html>
-<html>
-<head><title>)" + std::to_string(status_code) + " " + status_text + R"(</title></head>
-<body>
-    <h1>)" + std::to_string(status_code) + " " + status_text + R"(</h1>
-    <p>The server encountered an error processing your request.</p>
-    <hr>
-    <small>see-plus-plus/1.0</small>
-</body>
-</html>)";
+        if (!connection_manager.can_receive(fd, parser->remaining_body_bytes())) {
+            LOG_WARN("Announced body exceeds request size limit for fd:", fd);
+            send_error_response(fd, 413);
+            return false;
+        }
         
-        response.headers["Content-Length"] = std::to_string(response.body.size());
+        if (!parser->expects_continue()) {
+            return true;
+        }
         
-        std::string response_str = response.str();
-        ssize_t sent = send(fd, response_str.c_str(), response_str.size(), MSG_NOSIGNAL);
+        // The client holds the body back until we answer, so a request
+        // that would 404 anyway never costs its upload
+        if (!router.has_route(pending.method, pending.path)) {
+            LOG_DEBUG("Rejecting Expect: 100-continue for unrouted", pending.method, pending.path);
+            send_error_response(fd, 404);
+            return false;
+        }
         
-        if (sent == -1) {
-            LOG_ERROR("Failed to send error response to fd:", fd, "-", strerror(errno));
+        static constexpr char CONTINUE_RESPONSE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (send(fd, CONTINUE_RESPONSE, sizeof(CONTINUE_RESPONSE) - 1, MSG_NOSIGNAL) == -1) {
+            LOG_ERROR("Failed to send 100 Continue to fd:", fd, "-", strerror(errno));
+            return false;
         }
+        return true;
     }
 
     void EventLoop::handle_client_disconnect(int fd) {
@@ -327,6 +399,13 @@ namespace REACTOR {
         LOG_DEBUG("Disconnecting client fd:", fd, 
                  "(", conn->client_ip, ":", conn->client_port, ")");
 
+        // Drop any responses still waiting for the socket
+        {
+            std::lock_guard<std::mutex> lock(conn->write_mutex);
+            conn->pending_write.reset();
+            conn->queued_writes.clear();
+        }
+
         // Remove from event notifier
         notifier->remove_fd(fd);
         
@@ -11,13 +11,16 @@
 #include <chrono>
 
 namespace REACTOR {
-    static constexpr uint32_t FLAG_READ       = 1;
-    static constexpr uint32_t FLAG_DISCONNECT = 2;
-    static constexpr uint32_t FLAG_ERROR      = 3;
+    // Must match the EventNotifier bits; FLAG_ERROR used to be 3, which
+    // overlapped FLAG_READ and dropped every connection after a partial read
+    static constexpr uint32_t FLAG_READ       = EVENT_READ;
+    static constexpr uint32_t FLAG_WRITE      = EVENT_WRITE;
+    static constexpr uint32_t FLAG_DISCONNECT = EVENT_HANGUP;
+    static constexpr uint32_t FLAG_ERROR      = EVENT_ERROR;
 
     class EventLoop {
     public:
-        EventLoop(EXECUTOR::ThreadPool& thread_pool, CORE::Router &router);
+        EventLoop(EXECUTOR::ThreadPool& thread_pool, EXECUTOR::ThreadPool& io_pool, CORE::Router &router);
         ~EventLoop();
 
         bool setup_server_socket(uint16_t port);
@@ -32,13 +35,17 @@ namespace REACTOR {
         void handle_new_connections();
         void handle_client_event(int fd, uint32_t events);
         void handle_client_disconnect(int fd);
+        void resume_pending_write(int fd);
         void cleanup_timed_out_connections();
         void cleanup_worker();
         int make_socket_nonblocking(int socket_fd);
-        void send_error_response(int fd, int status_code, const std::string& status_text);
+        void send_error_response(int fd, int status_code);
+        bool serve_from_cache(const std::shared_ptr<CORE::ConnectionState>& conn, CORE::Request& request);
+        bool admit_request_body(int fd, CORE::HTTPParser* parser);
 
         std::unique_ptr<EventNotifier> notifier;
         EXECUTOR::ThreadPool* thread_pool;
+        EXECUTOR::ThreadPool* io_pool;      // For handlers that need blocking file I/O
         CORE::Router &router;
         CORE::ConnectionManager connection_manager;
         
@@ -82,10 +82,11 @@ namespace REACTOR {
                 events.push_back(read_event);
             }
 
-            // Add write filter if requested
+            // Add write filter if requested; EV_CLEAR makes it edge-triggered
+            // like EPOLLET, or an idle writable socket would fire every wait
             if (event_flags & EVENT_WRITE) {
                 struct kevent write_event;
-                EV_SET(&write_event, fd, EVFILT_WRITE, EV_ADD | EV_ENABLE, 0, 0, nullptr);
+                EV_SET(&write_event, fd, EVFILT_WRITE, EV_ADD | EV_ENABLE | EV_CLEAR, 0, 0, nullptr);
                 events.push_back(write_event);
             }
 
@@ -10,8 +10,9 @@ namespace SERVER {
         
         // Initialize components
         thread_pool = std::make_unique<EXECUTOR::ThreadPool>(num_workers);
+        io_pool = std::make_unique<EXECUTOR::ThreadPool>(IO_WORKERS);
         router = std::make_unique<CORE::Router>();
-        event_loop = std::make_unique<REACTOR::EventLoop>(*thread_pool, *router);
+        event_loop = std::make_unique<REACTOR::EventLoop>(*thread_pool, *io_pool, *router);
         
         // Set up signal handling
         instance.store(this);
@@ -34,6 +35,12 @@ namespace SERVER {
         std::cout << "Route added: " << method << " " << path << std::endl;
     }
 
+    void Server::add_mount(const std::string& method, const std::string& prefix, 
+                          std::shared_ptr<CORE::Controller> controller) {
+        router->add_mount(method, prefix, controller);
+        std::cout << "Mount added: " << method << " " << prefix << "/*" << std::endl;
+    }
+
     void Server::start() {
         if (running.load()) {
             std::cout << "Server is already running!" << std::endl;
@@ -77,6 +84,10 @@ namespace SERVER {
             thread_pool->shutdown();
         }
         
+        if (io_pool) {
+            io_pool->shutdown();
+        }
+        
         running.store(false);
         std::cout << "✅ Server shutdown complete" << std::endl;
     }
@@ -88,6 +99,10 @@ namespace SERVER {
     void Server::setup_signal_handlers() {
         std::signal(SIGINT, signal_handler);
         std::signal(SIGTERM, signal_handler);
+        
+        // sendfile() has no MSG_NOSIGNAL; a peer that hangs up mid-file
+        // must surface as EPIPE, not kill the process
+        std::signal(SIGPIPE, SIG_IGN);
     }
 
     void Server::signal_handler(int sig) {
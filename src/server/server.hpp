@@ -18,11 +18,48 @@ namespace SERVER {
     // the ability to add a route to our router
     class Server {
     public:
+        // Workers that may block on disk reads, kept apart from the request
+        // workers so a slow volume cannot stall request handling
+        static constexpr uint16_t IO_WORKERS = 4;
+
         Server(uint16_t port = 8080, uint16_t num_workers = 4);
         ~Server();
         // Route Management
         void add_route(const std::string& method, const std::string& path, 
                    std::shared_ptr<CORE::Controller> controller);
+        void add_mount(const std::string& method, const std::string& prefix, 
+                   std::shared_ptr<CORE::Controller> controller);
+        
+        // Middleware run around every request, in the order added (see
+        // CORE::MiddlewareChain)
+        template <typename M>
+        void use(std::shared_ptr<M> middleware) {
+            router->use(std::move(middleware));
+        }
+        
+        // Cache GET responses of routes matching `path` (see
+        // CORE::ResponseCache)
+        void cache_route(const std::string& path, CORE::CachePolicy policy) {
+            router->cache_route(path, std::move(policy));
+        }
+        
+        // Routes declared at compile time (see CORE::RouteTable)
+        template <typename Table>
+        void use_route_table() {
+            router->use_table<Table>();
+        }
+        
+        // Routes may change while the server runs: each call, or each
+        // update() as a whole, swaps in new routes without pausing
+        // requests, which finish on the routes they started with (see
+        // CORE::Router)
+        void remove_route(const std::string& method, const std::string& path) {
+            router->remove_route(method, path);
+        }
+        template <typename Edit>
+        void update_routes(Edit&& edit) {
+            router->update(std::forward<Edit>(edit));
+        }
 
         // Server Lifetime Methods
         void start();                   // Blocking call
@@ -49,6 +86,7 @@ namespace SERVER {
         std::unique_ptr<CORE::Router> router {};
         std::unique_ptr<REACTOR::EventLoop> event_loop {};
         std::unique_ptr<EXECUTOR::ThreadPool> thread_pool {};
+        std::unique_ptr<EXECUTOR::ThreadPool> io_pool {};
 
         bool keep_alive_enabled {};
         int request_timeout_seconds {};
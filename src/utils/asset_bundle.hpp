@@ -0,0 +1,426 @@
+#pragma once
+
+#include "content_coding.hpp"
+#include "file_cache.hpp"
+#include "file_handle.hpp"
+#include "file_reader.hpp"
+#include "mime_detector.hpp"
+#include "root_directory.hpp"
+#include "xxhash64.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UTILS {
+
+    // AssetBundle is a document root packed into one read-only file, for
+    // deployments whose static assets only change with a release. pack()
+    // does the per-file work once: ETag hashing, Last-Modified and
+    // Cache-Control values, and gzip (or a precompressed .gz/.br sibling)
+    // for text types. Serving then touches no filesystem paths at all.
+    //
+    // Layout, in host byte order:
+    //   Header | bodies and encoded variants | string blob | Entry index
+    // The index is sorted by relative path and read through an mmap() of
+    // the file, so a lookup is a binary search over shared, read-only
+    // pages. Bodies are never copied into memory: responses send them from
+    // the bundle's own fd with sendfile(), at each entry's offset.
+    //
+    // The bundle is a snapshot. Files changed under the document root are
+    // not seen until it is packed again.
+    class AssetBundle {
+    public:
+        struct PackResult {
+            bool success = false;
+            size_t file_count = 0;
+            uint64_t bundle_size = 0;
+            std::string error_message;
+        };
+
+        // Pack every regular file beneath `document_root` into `bundle_path`.
+        // Symlinks are skipped, as RootDirectory would refuse them. The bundle
+        // is written beside the target and renamed into place.
+        static PackResult pack(const std::string& document_root, const std::string& bundle_path) {
+            PackResult result;
+            RootDirectory root(document_root);
+            if (!root.valid()) {
+                result.error_message = "cannot open document root " + document_root;
+                return result;
+            }
+
+            std::vector<std::string> paths;
+            collect_files(document_root, "", paths);
+            std::sort(paths.begin(), paths.end());
+
+            std::string temp_path = bundle_path + ".tmp";
+            int out = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (out == -1) {
+                result.error_message = "cannot create " + temp_path + ": " + strerror(errno);
+                return result;
+            }
+
+            Packer packer(out);
+            if (!packer.pack(root, paths, result.error_message) ||
+                fsync(out) != 0 || rename(temp_path.c_str(), bundle_path.c_str()) != 0) {
+                if (result.error_message.empty()) {
+                    result.error_message = "cannot write " + bundle_path + ": " + strerror(errno);
+                }
+                unlink(temp_path.c_str());
+                return result;
+            }
+
+            result.success = true;
+            result.file_count = paths.size();
+            result.bundle_size = packer.offset;
+            return result;
+        }
+
+        explicit AssetBundle(const std::string& bundle_path) {
+            int fd = ::open(bundle_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1) {
+                error_ = "cannot open " + bundle_path + ": " + strerror(errno);
+                return;
+            }
+            handle_ = std::make_shared<FileHandle>(fd);
+
+            struct stat bundle_stat;
+            if (fstat(fd, &bundle_stat) != 0 || static_cast<size_t>(bundle_stat.st_size) < sizeof(Header)) {
+                error_ = bundle_path + " is not a bundle";
+                return;
+            }
+            map_size_ = static_cast<size_t>(bundle_stat.st_size);
+            void* map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                error_ = "cannot map " + bundle_path + ": " + strerror(errno);
+                return;
+            }
+            base_ = static_cast<const char*>(map);
+
+            if (!load_index()) {
+                error_ = bundle_path + " is damaged or from another version";
+                munmap(const_cast<char*>(base_), map_size_);
+                base_ = nullptr;
+            }
+        }
+
+        ~AssetBundle() {
+            if (base_) {
+                munmap(const_cast<char*>(base_), map_size_);
+            }
+        }
+
+        AssetBundle(const AssetBundle&) = delete;
+        AssetBundle& operator=(const AssetBundle&) = delete;
+
+        bool valid() const { return base_ != nullptr; }
+        const std::string& error() const { return error_; }
+        size_t size() const { return count_; }
+
+        // The file at `relative` (no leading '/') in the given coding, or
+        // null if there is no such file or no such variant of it
+        std::shared_ptr<const CachedFile> find(std::string_view relative,
+                                               ContentCoding coding = ContentCoding::IDENTITY) const {
+            const Entry* end = entries_ + count_;
+            const Entry* it = std::lower_bound(entries_, end, relative,
+                [this](const Entry& entry, std::string_view key) { return text(entry.path) < key; });
+            if (it == end || text(it->path) != relative) {
+                return nullptr;
+            }
+            return assets_[static_cast<size_t>(it - entries_)].files[static_cast<size_t>(coding)];
+        }
+
+    private:
+        static constexpr char MAGIC[8] = {'S', 'P', 'P', 'B', 'N', 'D', 'L', '1'};
+        static constexpr size_t CODED_VARIANTS = 2;      // gzip, br
+        static constexpr size_t MIN_COMPRESS_SIZE = 256; // Not worth gzip below this
+
+        // A byte range of the bundle file
+        struct Span {
+            uint64_t offset;
+            uint64_t length;
+        };
+
+        struct Variant {
+            Span body;                  // Empty if there is no variant
+            Span etag;
+        };
+
+        struct Entry {
+            Span path;                  // Relative to the document root
+            Span etag;
+            Span last_modified;         // HTTP-date text
+            Span cache_control;
+            Span body;
+            Variant variants[CODED_VARIANTS];
+            int64_t mtime_seconds;
+        };
+
+        struct Header {
+            char magic[8];
+            uint32_t entry_count;
+            uint32_t entry_size;        // sizeof(Entry), so a layout change is refused
+            uint64_t index_offset;
+            uint64_t total_size;
+        };
+
+        // The ready-made CachedFile of each coding of one entry
+        struct Asset {
+            std::shared_ptr<const CachedFile> files[1 + CODED_VARIANTS];
+        };
+
+        std::shared_ptr<const FileHandle> handle_;
+        const char* base_ = nullptr;
+        size_t map_size_ = 0;
+        const Entry* entries_ = nullptr;
+        size_t count_ = 0;
+        std::vector<Asset> assets_;
+        std::string error_;
+
+        std::string_view text(const Span& span) const {
+            return std::string_view(base_ + span.offset, span.length);
+        }
+
+        bool in_bounds(const Span& span) const {
+            return span.offset <= map_size_ && span.length <= map_size_ - span.offset;
+        }
+
+        // Check the header, every span and the sort order, then build the
+        // CachedFile for each entry so lookups hand out shared metadata
+        bool load_index() {
+            Header header;
+            std::memcpy(&header, base_, sizeof(header));
+            if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.entry_size != sizeof(Entry) ||
+                header.total_size != map_size_ || header.index_offset % alignof(Entry) != 0 ||
+                header.index_offset > map_size_ ||
+                header.entry_count > (map_size_ - header.index_offset) / sizeof(Entry)) {
+                return false;
+            }
+            entries_ = reinterpret_cast<const Entry*>(base_ + header.index_offset);
+            count_ = header.entry_count;
+
+            assets_.resize(count_);
+            for (size_t i = 0; i < count_; ++i) {
+                const Entry& entry = entries_[i];
+                if (!in_bounds(entry.path) || !in_bounds(entry.etag) || !in_bounds(entry.last_modified) ||
+                    !in_bounds(entry.cache_control) || !in_bounds(entry.body)) {
+                    return false;
+                }
+                if (i > 0 && !(text(entries_[i - 1].path) < text(entry.path))) {
+                    return false;
+                }
+
+                auto file = std::make_shared<CachedFile>();
+                file->handle = handle_;
+                file->offset = entry.body.offset;
+                file->file_size = static_cast<size_t>(entry.body.length);
+                file->last_modified = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(entry.mtime_seconds));
+                file->mtime_ns = entry.mtime_seconds * 1000000000;
+                file->mime_type = MimeTypeDetector::get_mime_type(text(entry.path));
+                file->etag = std::string(text(entry.etag));
+                file->last_modified_text = std::string(text(entry.last_modified));
+                file->cache_control = std::string(text(entry.cache_control));
+                assets_[i].files[0] = file;
+
+                for (size_t v = 0; v < CODED_VARIANTS; ++v) {
+                    const Variant& variant = entry.variants[v];
+                    if (variant.body.length == 0) continue;
+                    if (!in_bounds(variant.body) || !in_bounds(variant.etag)) {
+                        return false;
+                    }
+                    auto coded = std::make_shared<CachedFile>(*file);
+                    coded->offset = variant.body.offset;
+                    coded->file_size = static_cast<size_t>(variant.body.length);
+                    coded->etag = std::string(text(variant.etag));
+                    assets_[i].files[1 + v] = std::move(coded);
+                }
+            }
+            return true;
+        }
+
+        // Relative paths of the regular files under `directory`
+        static void collect_files(const std::string& root, const std::string& relative,
+                                  std::vector<std::string>& paths) {
+            std::string directory = root + "/" + relative;
+            DIR* dir = opendir(directory.c_str());
+            if (!dir) return;
+            while (dirent* item = readdir(dir)) {
+                std::string name = item->d_name;
+                if (name == "." || name == "..") continue;
+
+                struct stat item_stat;
+                if (lstat((directory + name).c_str(), &item_stat) != 0) continue;
+                if (S_ISDIR(item_stat.st_mode)) {
+                    collect_files(root, relative + name + "/", paths);
+                } else if (S_ISREG(item_stat.st_mode)) {
+                    paths.push_back(relative + name);
+                }
+            }
+            closedir(dir);
+        }
+
+        // Writes bodies as it goes and keeps the index and strings in
+        // memory until the end. String spans are relative to the blob
+        // until it is placed.
+        struct Packer {
+            FileHandle out;
+            uint64_t offset = sizeof(Header);
+            std::vector<Entry> entries;
+            std::string strings;
+            std::unordered_map<std::string, size_t> by_path;
+
+            explicit Packer(int fd) : out(fd) {}
+
+            bool pack(const RootDirectory& root, const std::vector<std::string>& paths, std::string& error) {
+                entries.reserve(paths.size());
+                for (const std::string& path : paths) {
+                    bool has_gzip_sibling = std::binary_search(paths.begin(), paths.end(), path + ".gz");
+                    if (!add_file(root, path, !has_gzip_sibling, error)) return false;
+                }
+
+                // Precompressed siblings become the variants of their
+                // originals, sharing the sibling's bytes
+                for (Entry& entry : entries) {
+                    std::string path(string_at(entry.path));
+                    for (ContentCoding coding : {ContentCoding::GZIP, ContentCoding::BR}) {
+                        auto sibling = by_path.find(path + std::string(coding_suffix(coding)));
+                        if (sibling == by_path.end()) continue;
+                        Variant& variant = entry.variants[static_cast<size_t>(coding) - 1];
+                        const Entry& encoded = entries[sibling->second];
+                        variant.body = encoded.body;
+                        variant.etag = add_string(variant_etag(string_at(encoded.etag), coding));
+                    }
+                }
+
+                uint64_t blob_offset = offset;
+                if (!write_all(strings.data(), strings.size())) return fail(error);
+                for (Entry& entry : entries) {
+                    for (Span* span : {&entry.path, &entry.etag, &entry.last_modified, &entry.cache_control,
+                                       &entry.variants[0].etag, &entry.variants[1].etag}) {
+                        span->offset += blob_offset;
+                    }
+                }
+
+                static const char padding[alignof(Entry)] = {};
+                if (!write_all(padding, (alignof(Entry) - offset % alignof(Entry)) % alignof(Entry))) {
+                    return fail(error);
+                }
+                Header header {};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.entry_count = static_cast<uint32_t>(entries.size());
+                header.entry_size = sizeof(Entry);
+                header.index_offset = offset;
+                if (!write_all(entries.data(), entries.size() * sizeof(Entry))) return fail(error);
+                header.total_size = offset;
+                if (pwrite(out.fd(), &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+                    return fail(error);
+                }
+                return true;
+            }
+
+            bool add_file(const RootDirectory& root, const std::string& path, bool may_gzip,
+                          std::string& error) {
+                FileInfo info = FileReader::open_file(root, path.c_str());
+                if (!info.success) {
+                    error = "cannot read " + path + ": " + info.error_message;
+                    return false;
+                }
+
+                Entry entry {};
+                entry.path = add_string(path);
+                entry.mtime_seconds = static_cast<int64_t>(std::chrono::system_clock::to_time_t(info.last_modified));
+                entry.last_modified = add_string(FileReader::format_http_date(info.last_modified));
+                entry.cache_control = add_string(FileReader::generate_cache_control(info.mime_type));
+                entry.body.offset = offset;
+                entry.body.length = info.file_size;
+
+                // Small files are read whole so text types can be gzipped;
+                // anything larger is copied through in chunks
+                uint64_t hash;
+                std::string content;
+                if (info.file_size <= FileCache::MAX_ENTRY_SIZE) {
+                    if (!FileReader::read_contents(*info.handle, info.file_size, content) ||
+                        !write_all(content.data(), content.size())) {
+                        return fail(error, path);
+                    }
+                    hash = XXHash64::hash(content);
+                } else if (!copy_contents(*info.handle, info.file_size, hash)) {
+                    return fail(error, path);
+                }
+                std::string etag = FileReader::generate_etag(hash);
+                entry.etag = add_string(etag);
+
+                std::string encoded;
+                if (may_gzip && content.size() >= MIN_COMPRESS_SIZE && MimeTypeDetector::is_compressible(info.mime_type) &&
+                    Gzip::compress(content, encoded) && encoded.size() < content.size()) {
+                    Variant& gzip = entry.variants[static_cast<size_t>(ContentCoding::GZIP) - 1];
+                    gzip.body = Span{offset, encoded.size()};
+                    gzip.etag = add_string(variant_etag(etag, ContentCoding::GZIP));
+                    if (!write_all(encoded.data(), encoded.size())) return fail(error, path);
+                }
+
+                by_path.emplace(path, entries.size());
+                entries.push_back(entry);
+                return true;
+            }
+
+            bool copy_contents(const FileHandle& file, size_t length, uint64_t& hash) {
+                static constexpr size_t COPY_CHUNK = 256 * 1024;
+                std::vector<char> buffer(COPY_CHUNK);
+                XXHash64 state;
+                size_t done = 0;
+                while (done < length) {
+                    size_t want = length - done < COPY_CHUNK ? length - done : COPY_CHUNK;
+                    ssize_t n = pread(file.fd(), buffer.data(), want, static_cast<off_t>(done));
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0 || !write_all(buffer.data(), static_cast<size_t>(n))) return false;
+                    state.update(buffer.data(), static_cast<size_t>(n));
+                    done += static_cast<size_t>(n);
+                }
+                hash = state.digest();
+                return true;
+            }
+
+            bool write_all(const void* data, size_t length) {
+                const char* p = static_cast<const char*>(data);
+                while (length > 0) {
+                    ssize_t n = pwrite(out.fd(), p, length, static_cast<off_t>(offset));
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) return false;
+                    p += n;
+                    length -= static_cast<size_t>(n);
+                    offset += static_cast<uint64_t>(n);
+                }
+                return true;
+            }
+
+            Span add_string(std::string_view value) {
+                Span span{strings.size(), value.size()};
+                strings.append(value);
+                return span;
+            }
+
+            std::string_view string_at(const Span& span) const {
+                return std::string_view(strings).substr(span.offset, span.length);
+            }
+
+            static bool fail(std::string& error, const std::string& path = "") {
+                error = "write failed" + (path.empty() ? std::string() : " at " + path) + ": " + strerror(errno);
+                return false;
+            }
+        };
+    };
+
+} // namespace UTILS
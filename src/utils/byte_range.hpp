@@ -0,0 +1,118 @@
+#pragma once
+
+#include "perfect_hash.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace UTILS {
+
+    // Inclusive byte range [first, last] of a representation
+    struct ByteRange {
+        uint64_t first = 0;
+        uint64_t last = 0;
+
+        uint64_t length() const { return last - first + 1; }
+    };
+
+    enum class RangeResult {
+        IGNORE,          // No usable Range header: send the full representation (200)
+        SATISFIABLE,     // At least one range overlaps the file (206)
+        UNSATISFIABLE    // Well-formed, but nothing overlaps the file (416)
+    };
+
+    // Parses "Range: bytes=..." (RFC 7233) against a representation of
+    // `size` bytes. Malformed headers and unknown units are ignored rather
+    // than rejected, as the RFC allows. Overlapping or adjacent ranges are
+    // coalesced, and more than MAX_RANGES ranges are treated as malformed
+    // so a client cannot make us emit thousands of tiny parts.
+    class RangeParser {
+    public:
+        static constexpr size_t MAX_RANGES = 16;
+
+        static RangeResult parse(std::string_view header, uint64_t size,
+                                 std::vector<ByteRange>& ranges) {
+            ranges.clear();
+
+            constexpr std::string_view UNIT = "bytes=";
+            if (header.size() < UNIT.size() || !iequals(header.substr(0, UNIT.size()), UNIT)) {
+                return RangeResult::IGNORE;
+            }
+            header.remove_prefix(UNIT.size());
+
+            size_t specs = 0;
+            while (!header.empty()) {
+                size_t comma = header.find(',');
+                std::string_view spec = trim(header.substr(0, comma));
+                header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+                if (spec.empty()) continue; // Tolerate empty list elements
+                if (++specs > MAX_RANGES) return RangeResult::IGNORE;
+
+                size_t dash = spec.find('-');
+                if (dash == std::string_view::npos) return RangeResult::IGNORE;
+                std::string_view first_text = spec.substr(0, dash);
+                std::string_view last_text = spec.substr(dash + 1);
+
+                ByteRange range;
+                if (first_text.empty()) {
+                    // Suffix range "-N": the last N bytes
+                    uint64_t suffix = 0;
+                    if (!parse_number(last_text, suffix)) return RangeResult::IGNORE;
+                    if (suffix == 0 || size == 0) continue;
+                    range.first = suffix >= size ? 0 : size - suffix;
+                    range.last = size - 1;
+                } else {
+                    if (!parse_number(first_text, range.first)) return RangeResult::IGNORE;
+                    if (last_text.empty()) {
+                        range.last = size ? size - 1 : 0;
+                    } else {
+                        if (!parse_number(last_text, range.last)) return RangeResult::IGNORE;
+                        if (range.last < range.first) return RangeResult::IGNORE;
+                        if (size && range.last >= size) range.last = size - 1;
+                    }
+                    if (range.first >= size) continue; // Unsatisfiable on its own
+                }
+                ranges.push_back(range);
+            }
+
+            if (specs == 0) return RangeResult::IGNORE;
+            if (ranges.empty()) return RangeResult::UNSATISFIABLE;
+
+            coalesce(ranges);
+            return RangeResult::SATISFIABLE;
+        }
+
+    private:
+        static std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+
+        static bool parse_number(std::string_view text, uint64_t& value) {
+            if (text.empty()) return false;
+            auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return ec == std::errc() && end == text.data() + text.size();
+        }
+
+        static void coalesce(std::vector<ByteRange>& ranges) {
+            if (ranges.size() < 2) return;
+            std::sort(ranges.begin(), ranges.end(),
+                      [](const ByteRange& a, const ByteRange& b) { return a.first < b.first; });
+            size_t out = 0;
+            for (size_t i = 1; i < ranges.size(); ++i) {
+                if (ranges[i].first <= ranges[out].last + 1) {
+                    ranges[out].last = std::max(ranges[out].last, ranges[i].last);
+                } else {
+                    ranges[++out] = ranges[i];
+                }
+            }
+            ranges.resize(out + 1);
+        }
+    };
+
+} // namespace UTILS
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "file_cache.hpp"
+#include "perfect_hash.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace UTILS {
+
+    enum class ContentCoding : uint8_t {
+        IDENTITY,
+        GZIP,
+        BR
+    };
+
+    constexpr std::string_view coding_name(ContentCoding coding) {
+        switch (coding) {
+            case ContentCoding::GZIP: return "gzip";
+            case ContentCoding::BR:   return "br";
+            default:                  return "identity";
+        }
+    }
+
+    // File name suffix of a precompressed sibling ("style.css.gz")
+    constexpr std::string_view coding_suffix(ContentCoding coding) {
+        switch (coding) {
+            case ContentCoding::GZIP: return ".gz";
+            case ContentCoding::BR:   return ".br";
+            default:                  return "";
+        }
+    }
+
+    // ETag of an encoded representation: the source's, tagged with the
+    // coding so it never matches the identity body's
+    inline std::string variant_etag(std::string_view etag, ContentCoding coding) {
+        if (!etag.empty() && etag.back() == '"') etag.remove_suffix(1);
+        std::string tagged;
+        tagged.reserve(etag.size() + 8);
+        tagged.append(etag).append("-").append(coding_name(coding)).append("\"");
+        return tagged;
+    }
+
+    // The codings a client accepts, from Accept-Encoding (RFC 9110 12.5.3).
+    // "q=0" excludes a coding, and "*" covers every coding not named.
+    struct AcceptedCodings {
+        bool gzip = false;
+        bool br = false;
+
+        static AcceptedCodings parse(std::string_view header) {
+            AcceptedCodings accepted;
+            bool named_gzip = false, named_br = false;
+            bool wildcard = false;
+
+            while (!header.empty()) {
+                size_t comma = header.find(',');
+                std::string_view item = header.substr(0, comma);
+                header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+                size_t semicolon = item.find(';');
+                std::string_view token = trim(item.substr(0, semicolon));
+                bool allowed = semicolon == std::string_view::npos || !zero_quality(item.substr(semicolon + 1));
+
+                if (iequals(token, "gzip") || iequals(token, "x-gzip")) {
+                    named_gzip = true;
+                    accepted.gzip = allowed;
+                } else if (iequals(token, "br")) {
+                    named_br = true;
+                    accepted.br = allowed;
+                } else if (token == "*") {
+                    wildcard = allowed;
+                }
+            }
+
+            if (wildcard) {
+                if (!named_gzip) accepted.gzip = true;
+                if (!named_br) accepted.br = true;
+            }
+            return accepted;
+        }
+
+    private:
+        static std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+
+        // True for "q=0", "q=0.0" and so on
+        static bool zero_quality(std::string_view params) {
+            params = trim(params);
+            if (params.size() < 3 || (params[0] != 'q' && params[0] != 'Q') || params[1] != '=') {
+                return false;
+            }
+            for (char c : trim(params.substr(2))) {
+                if (c != '0' && c != '.') return false;
+            }
+            return true;
+        }
+    };
+
+    // One-shot gzip with zlib. Each thread keeps its own deflate stream and
+    // resets it between calls, so the ~256KB of compressor state is set up
+    // once per worker rather than once per response.
+    class Gzip {
+    public:
+        static constexpr int LEVEL = 6;
+
+        static bool compress(std::string_view input, std::string& output) {
+            Context& context = thread_context();
+            if (!context.ready || deflateReset(&context.stream) != Z_OK) {
+                return false;
+            }
+
+            z_stream& stream = context.stream;
+            output.resize(deflateBound(&stream, input.size()));
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+            stream.avail_in = static_cast<uInt>(input.size());
+            stream.next_out = reinterpret_cast<Bytef*>(output.data());
+            stream.avail_out = static_cast<uInt>(output.size());
+
+            if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+                output.clear();
+                return false;
+            }
+            output.resize(stream.total_out);
+            return true;
+        }
+
+    private:
+        struct Context {
+            z_stream stream {};
+            bool ready = false;
+
+            Context() {
+                // windowBits 15 + 16 selects the gzip wrapper
+                ready = deflateInit2(&stream, LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            }
+            ~Context() {
+                if (ready) deflateEnd(&stream);
+            }
+        };
+
+        static Context& thread_context() {
+            thread_local Context context;
+            return context;
+        }
+    };
+
+    // EncodedCache holds the encoded variants of static files, keyed by the
+    // variant's path ("/srv/app.js.gz") and tagged with the ETag of the
+    // file it encodes. A variant is either a precompressed sibling served
+    // under the original's headers, or gzip output made on the fly; a null
+    // variant records that neither is worth serving. Entries also carry the
+    // FileCache generation, since a sibling may appear or change without the
+    // original's ETag moving.
+    class EncodedCache {
+    public:
+        static constexpr size_t SHARD_COUNT = 8;
+        static constexpr size_t DEFAULT_BYTE_BUDGET = 16 * 1024 * 1024;  // 16MB
+        static constexpr size_t ENTRY_OVERHEAD = 256;                    // Bookkeeping estimate
+
+        explicit EncodedCache(size_t byte_budget = DEFAULT_BYTE_BUDGET)
+            : shard_budget_(byte_budget / SHARD_COUNT) {}
+
+        EncodedCache(const EncodedCache&) = delete;
+        EncodedCache& operator=(const EncodedCache&) = delete;
+
+        // True if the variant for `key` is known for this source version;
+        // `variant` is then set, possibly to null
+        bool find(const std::string& key, std::string_view source_etag, uint64_t generation,
+                  std::shared_ptr<const CachedFile>& variant) {
+            Shard& shard = shard_for(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end()) {
+                return false;
+            }
+            if (it->second.source_etag != source_etag || it->second.generation != generation) {
+                erase(shard, it);
+                return false;
+            }
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.position);
+            variant = it->second.variant;
+            return true;
+        }
+
+        void insert(const std::string& key, std::string_view source_etag, uint64_t generation,
+                    std::shared_ptr<const CachedFile> variant) {
+            size_t cost = key.size() + ENTRY_OVERHEAD;
+            if (variant && variant->content) {
+                cost += variant->content->size();
+            }
+            if (cost > shard_budget_) {
+                return;
+            }
+
+            Shard& shard = shard_for(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto existing = shard.entries.find(key);
+            if (existing != shard.entries.end()) {
+                erase(shard, existing);
+            }
+            while (shard.bytes + cost > shard_budget_ && !shard.lru.empty()) {
+                erase(shard, shard.entries.find(shard.lru.back()));
+            }
+
+            shard.lru.push_front(key);
+            shard.entries.emplace(key, Slot{std::string(source_etag), generation, std::move(variant),
+                                            shard.lru.begin(), cost});
+            shard.bytes += cost;
+        }
+
+    private:
+        struct Slot {
+            std::string source_etag;
+            uint64_t generation;
+            std::shared_ptr<const CachedFile> variant;
+            std::list<std::string>::iterator position;
+            size_t cost;
+        };
+
+        struct Shard {
+            mutable std::mutex mutex;
+            std::list<std::string> lru;   // Front is most recently used
+            std::unordered_map<std::string, Slot> entries;
+            size_t bytes = 0;
+        };
+
+        Shard shards_[SHARD_COUNT];
+        size_t shard_budget_;
+
+        Shard& shard_for(const std::string& key) {
+            return shards_[std::hash<std::string>{}(key) % SHARD_COUNT];
+        }
+
+        static void erase(Shard& shard, std::unordered_map<std::string, Slot>::iterator it) {
+            shard.bytes -= it->second.cost;
+            shard.lru.erase(it->second.position);
+            shard.entries.erase(it);
+        }
+    };
+
+} // namespace UTILS
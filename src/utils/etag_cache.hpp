@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+
+namespace UTILS {
+
+    // Identity of one version of a file, as far as stat() can tell
+    struct FileVersion {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        int64_t ctime_ns = 0;
+
+        static FileVersion of(const struct stat& st) {
+            FileVersion version;
+            version.device = static_cast<uint64_t>(st.st_dev);
+            version.inode = static_cast<uint64_t>(st.st_ino);
+            version.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+            version.mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+            version.ctime_ns = static_cast<int64_t>(st.st_ctimespec.tv_sec) * 1000000000 + st.st_ctimespec.tv_nsec;
+#else
+            version.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+            version.ctime_ns = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+#endif
+            return version;
+        }
+
+        bool operator==(const FileVersion& other) const {
+            return device == other.device && inode == other.inode && size == other.size &&
+                   mtime_ns == other.mtime_ns && ctime_ns == other.ctime_ns;
+        }
+    };
+
+    // EtagCache remembers the content ETag of each file version, so a file
+    // is hashed once per change rather than every time it drops out of
+    // FileCache or OpenFileCache. That matters for large files, which
+    // OpenFileCache reopens every TTL. Any write moves mtime/ctime, so a
+    // stale tag is never returned for changed contents.
+    //
+    // Entries are tiny; when a shard is full an arbitrary one is dropped,
+    // which only costs a rehash.
+    class EtagCache {
+    public:
+        static constexpr size_t SHARD_COUNT = 8;
+        static constexpr size_t MAX_ENTRIES = 8192;
+
+        bool find(const std::string& path, const FileVersion& version, std::string& etag) {
+            Shard& shard = shard_for(path);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(path);
+            if (it == shard.entries.end() || !(it->second.version == version)) {
+                return false;
+            }
+            etag = it->second.etag;
+            return true;
+        }
+
+        void insert(const std::string& path, const FileVersion& version, const std::string& etag) {
+            Shard& shard = shard_for(path);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(path);
+            if (it == shard.entries.end() && shard.entries.size() >= MAX_ENTRIES / SHARD_COUNT) {
+                shard.entries.erase(shard.entries.begin());
+            }
+            shard.entries[path] = Entry{version, etag};
+        }
+
+    private:
+        struct Entry {
+            FileVersion version;
+            std::string etag;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, Entry> entries;
+        };
+
+        Shard shards_[SHARD_COUNT];
+
+        Shard& shard_for(const std::string& path) {
+            return shards_[std::hash<std::string>{}(path) % SHARD_COUNT];
+        }
+    };
+
+} // namespace UTILS
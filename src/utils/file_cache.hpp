@@ -0,0 +1,366 @@
+#pragma once
+
+#include "file_handle.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <poll.h>
+#endif
+
+namespace UTILS {
+
+    // Immutable snapshot of a static file and the header values derived from
+    // it. Shared between the cache and in-flight responses, so a response
+    // keeps its body even if the entry is evicted meanwhile.
+    struct CachedFile {
+        std::shared_ptr<const std::string> content;
+        std::shared_ptr<const FileHandle> handle;  // Instead of content, for large files
+        uint64_t offset = 0;             // Where the body starts in handle's file
+        size_t file_size = 0;
+        std::chrono::system_clock::time_point last_modified;
+        int64_t mtime_ns = 0;            // Exact mtime, for stat revalidation
+        std::string_view mime_type;      // Static storage
+        std::string etag;
+        std::string last_modified_text;
+        std::string cache_control;
+    };
+
+    // A cached path and the hits it has taken while cached
+    struct PathHits {
+        std::string path;
+        uint64_t hits;
+    };
+
+    // FileCache keeps small static files in memory, keyed by their resolved
+    // path. It is split into shards, each an LRU list with its own mutex and
+    // an equal share of the byte budget, so concurrent hits on different
+    // files rarely contend.
+    //
+    // On Linux an inotify watcher thread covers the document root and every
+    // directory below it and drops entries as soon as their file changes.
+    // Elsewhere, or if inotify is unavailable, each hit is revalidated with
+    // a stat() of size and mtime instead.
+    class FileCache {
+    public:
+        static constexpr size_t SHARD_COUNT = 16;
+        static constexpr size_t DEFAULT_BYTE_BUDGET = 64 * 1024 * 1024;  // 64MB
+        static constexpr size_t MAX_ENTRY_SIZE = 1024 * 1024;            // 1MB per file
+        static constexpr size_t ENTRY_OVERHEAD = 256;                    // Bookkeeping estimate
+
+        struct Stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            size_t entries = 0;
+            size_t bytes = 0;
+        };
+
+        explicit FileCache(const std::string& document_root,
+                           size_t byte_budget = DEFAULT_BYTE_BUDGET)
+            : shard_budget_(byte_budget / SHARD_COUNT) {
+            start_watching(document_root);
+        }
+
+        ~FileCache() {
+            stop_watching();
+        }
+
+        FileCache(const FileCache&) = delete;
+        FileCache& operator=(const FileCache&) = delete;
+
+        std::shared_ptr<const CachedFile> find(const std::string& path) {
+            Shard& shard = shard_for(path);
+            std::shared_ptr<const CachedFile> entry;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto it = shard.entries.find(path);
+                if (it == shard.entries.end()) {
+                    misses_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second.position);
+                ++it->second.hits;
+                entry = it->second.file;
+            }
+
+            if (!watching_ && !still_current(path, *entry)) {
+                invalidate(path);
+                misses_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return entry;
+        }
+
+        // Take this before reading a file and pass it to insert(); if any
+        // invalidation happened in between the insert is dropped, so a
+        // change that raced with the read can never be cached as current
+        uint64_t generation() const {
+            return generation_.load(std::memory_order_acquire);
+        }
+
+        bool insert(const std::string& path, std::shared_ptr<const CachedFile> file,
+                    uint64_t generation_seen) {
+            if (!file->content) {
+                return false;
+            }
+            size_t cost = file->content->size() + path.size() + ENTRY_OVERHEAD;
+            if (file->content->size() > MAX_ENTRY_SIZE || cost > shard_budget_) {
+                return false;
+            }
+
+            Shard& shard = shard_for(path);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (generation_.load(std::memory_order_acquire) != generation_seen) {
+                return false;
+            }
+
+            auto existing = shard.entries.find(path);
+            if (existing != shard.entries.end()) {
+                erase(shard, existing);
+            }
+
+            while (shard.bytes + cost > shard_budget_ && !shard.lru.empty()) {
+                erase(shard, shard.entries.find(shard.lru.back()));
+            }
+
+            shard.lru.push_front(path);
+            shard.entries.emplace(path, Node{std::move(file), shard.lru.begin(), cost});
+            shard.bytes += cost;
+            return true;
+        }
+
+        void invalidate(const std::string& path) {
+            generation_.fetch_add(1, std::memory_order_acq_rel);
+            Shard& shard = shard_for(path);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(path);
+            if (it != shard.entries.end()) {
+                erase(shard, it);
+            }
+        }
+
+        void clear() {
+            generation_.fetch_add(1, std::memory_order_acq_rel);
+            for (Shard& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.entries.clear();
+                shard.lru.clear();
+                shard.bytes = 0;
+            }
+        }
+
+        Stats stats() const {
+            Stats stats;
+            stats.hits = hits_.load(std::memory_order_relaxed);
+            stats.misses = misses_.load(std::memory_order_relaxed);
+            for (const Shard& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                stats.entries += shard.entries.size();
+                stats.bytes += shard.bytes;
+            }
+            return stats;
+        }
+
+        void collect_hits(std::vector<PathHits>& out) const {
+            for (const Shard& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (const auto& [path, node] : shard.entries) {
+                    out.push_back(PathHits{path, node.hits});
+                }
+            }
+        }
+
+        bool is_watching() const { return watching_; }
+
+        static int64_t mtime_ns(const struct stat& st) {
+#ifdef __APPLE__
+            return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+            return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        }
+
+    private:
+        struct Node {
+            std::shared_ptr<const CachedFile> file;
+            std::list<std::string>::iterator position;
+            size_t cost;
+            uint64_t hits = 0;
+        };
+
+        struct Shard {
+            mutable std::mutex mutex;
+            std::list<std::string> lru;   // Front is most recently used
+            std::unordered_map<std::string, Node> entries;
+            size_t bytes = 0;
+        };
+
+        Shard shards_[SHARD_COUNT];
+        size_t shard_budget_;
+        std::atomic<uint64_t> generation_{0};
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+
+        bool watching_ = false;
+        std::atomic<bool> stop_{false};
+        std::thread watcher_;
+
+        Shard& shard_for(const std::string& path) {
+            return shards_[std::hash<std::string>{}(path) % SHARD_COUNT];
+        }
+
+        static void erase(Shard& shard, std::unordered_map<std::string, Node>::iterator it) {
+            shard.bytes -= it->second.cost;
+            shard.lru.erase(it->second.position);
+            shard.entries.erase(it);
+        }
+
+        static bool still_current(const std::string& path, const CachedFile& file) {
+            struct stat st;
+            return stat(path.c_str(), &st) == 0 &&
+                   static_cast<size_t>(st.st_size) == file.file_size &&
+                   mtime_ns(st) == file.mtime_ns;
+        }
+
+#ifdef __linux__
+        static constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                               IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                               IN_DELETE_SELF | IN_MOVE_SELF;
+
+        int inotify_fd_ = -1;
+        std::mutex watch_mutex_;
+        std::unordered_map<int, std::string> watched_dirs_;  // wd -> directory path with '/'
+
+        void start_watching(const std::string& document_root) {
+            inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (inotify_fd_ == -1) {
+                return; // Fall back to stat revalidation
+            }
+            std::string root = document_root;
+            if (!root.empty() && root.back() != '/') {
+                root += '/';
+            }
+            if (!watch_tree(root)) {
+                close(inotify_fd_);
+                inotify_fd_ = -1;
+                return;
+            }
+            watching_ = true;
+            watcher_ = std::thread(&FileCache::watch_loop, this);
+        }
+
+        void stop_watching() {
+            stop_.store(true);
+            if (watcher_.joinable()) {
+                watcher_.join();
+            }
+            if (inotify_fd_ != -1) {
+                close(inotify_fd_);
+            }
+        }
+
+        // Watch `dir` and every directory below it (inotify is not recursive)
+        bool watch_tree(const std::string& dir) {
+            int wd = inotify_add_watch(inotify_fd_, dir.c_str(), WATCH_MASK);
+            if (wd == -1) {
+                return false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(watch_mutex_);
+                watched_dirs_[wd] = dir;
+            }
+
+            DIR* handle = opendir(dir.c_str());
+            if (!handle) {
+                return true;
+            }
+            while (dirent* item = readdir(handle)) {
+                std::string_view name = item->d_name;
+                if (name == "." || name == "..") continue;
+
+                bool is_dir = item->d_type == DT_DIR;
+                if (item->d_type == DT_UNKNOWN) {
+                    struct stat st;
+                    std::string child = dir + item->d_name;
+                    is_dir = lstat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+                }
+                if (is_dir && !watch_tree(dir + item->d_name + "/")) {
+                    closedir(handle);
+                    return false;
+                }
+            }
+            closedir(handle);
+            return true;
+        }
+
+        void watch_loop() {
+            alignas(inotify_event) char buffer[16 * 1024];
+            while (!stop_.load()) {
+                pollfd pfd {inotify_fd_, POLLIN, 0};
+                if (poll(&pfd, 1, 500) <= 0) {
+                    continue;
+                }
+                ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    handle_event(*event);
+                    offset += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+        void handle_event(const inotify_event& event) {
+            if (event.mask & IN_Q_OVERFLOW) {
+                clear(); // Events were lost, trust nothing
+                return;
+            }
+
+            std::string dir;
+            {
+                std::lock_guard<std::mutex> lock(watch_mutex_);
+                auto it = watched_dirs_.find(event.wd);
+                if (it == watched_dirs_.end()) return;
+                if (event.mask & IN_IGNORED) {
+                    watched_dirs_.erase(it);
+                    return;
+                }
+                dir = it->second;
+            }
+
+            // A directory appearing, vanishing or moving can change many
+            // paths at once; new ones need watching, and the cache is cleared
+            if ((event.mask & IN_ISDIR) || (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF))) {
+                if ((event.mask & (IN_CREATE | IN_MOVED_TO)) && event.len > 0) {
+                    watch_tree(dir + event.name + "/");
+                }
+                clear();
+                return;
+            }
+
+            if (event.len > 0) {
+                invalidate(dir + event.name);
+            }
+        }
+#else
+        void start_watching(const std::string&) {}
+        void stop_watching() {}
+#endif
+    };
+
+} // namespace UTILS
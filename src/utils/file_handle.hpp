@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <unistd.h>
+
+namespace UTILS {
+
+    // FileHandle owns an open file descriptor and closes it on destruction.
+    // Responses hold it through a shared_ptr so the file stays open until
+    // the send path is done with it, whichever thread that ends up on.
+    class FileHandle {
+    public:
+        explicit FileHandle(int fd) : fd_(fd) {}
+        ~FileHandle() {
+            if (fd_ != -1) {
+                close(fd_);
+            }
+        }
+
+        FileHandle(const FileHandle&) = delete;
+        FileHandle& operator=(const FileHandle&) = delete;
+
+        int fd() const { return fd_; }
+
+    private:
+        int fd_;
+    };
+
+    // A byte range of an open file, sent straight from the page cache
+    struct FileSlice {
+        std::shared_ptr<const FileHandle> file;
+        uint64_t offset = 0;
+        uint64_t length = 0;
+
+        explicit operator bool() const { return file != nullptr; }
+    };
+
+} // namespace UTILS
@@ -1,23 +1,28 @@
 #pragma once
 
 #include "mime_detector.hpp"
+#include "http_date.hpp"
+#include "file_handle.hpp"
+#include "xxhash64.hpp"
+#include "root_directory.hpp"
 #include <string>
-#include <fstream>
+#include <string_view>
 #include <sys/stat.h>    // For file metadata
+#include <fcntl.h>       // For posix_fadvise
+#include <errno.h>
+#include <memory>
 #include <chrono>
-#include <ctime>
-#include <sstream>
-#include <iomanip>
 
 namespace UTILS {
 
 
     struct FileInfo {
-        std::string content;                                    // The actual file contents
-        std::string mime_type;                                  // Content-Type for HTTP header
+        std::shared_ptr<const FileHandle> handle;               // Open descriptor
+        std::string_view mime_type;                             // Content-Type for HTTP header (static storage)
         size_t file_size;                                       // Content-Length for HTTP header
         std::chrono::system_clock::time_point last_modified;    // Last-Modified for HTTP header
-        bool success;                                           // Did we successfully read it?
+        bool success;                                           // Did we successfully open it?
+        bool not_found = false;                                 // Failed because it is missing or unreadable
         std::string error_message;                              // If not, what went wrong?
         
         FileInfo() : file_size(0), success(false) {}
@@ -26,92 +31,85 @@ namespace UTILS {
 
     class FileReader {
     public:
-        // Safety limits to prevent memory exhaustion or DoS attacks
-        static constexpr size_t MAX_FILE_SIZE = 10 * 1024 * 1024;  // 10MB max
         static constexpr size_t CHUNK_SIZE = 64 * 1024;            // 64KB read chunks
+        static constexpr size_t READAHEAD_WINDOW = 2 * 1024 * 1024; // Prefetched on open
         
-        static FileInfo read_file(const std::string& file_path) {
-            FileInfo info;
-            
-            try {
-                // Step 1: Get file metadata using POSIX stat() call
-                struct stat file_stat;
-                if (stat(file_path.c_str(), &file_stat) != 0) {
-                    info.error_message = "File not found or inaccessible";
-                    return info;
-                }
-                
-                // Step 2: Validate it's a regular file (not directory, device, etc.)
-                if (!S_ISREG(file_stat.st_mode)) {
-                    info.error_message = "Not a regular file";
-                    return info;
-                }
-                
-                // Step 3: Check file size limits for safety
-                if (static_cast<size_t>(file_stat.st_size) > MAX_FILE_SIZE) {
-                    info.error_message = "File too large (max " + 
-                        std::to_string(MAX_FILE_SIZE / (1024*1024)) + "MB)";
-                    return info;
-                }
-                
-                // Step 4: Convert Unix timestamp to C++ time_point
-                auto time_since_epoch = std::chrono::seconds(file_stat.st_mtime);
-                info.last_modified = std::chrono::system_clock::time_point(time_since_epoch);
-                info.file_size = static_cast<size_t>(file_stat.st_size);
-                
-                // Step 5: Actually read the file content
-                std::ifstream file(file_path, std::ios::binary);
-                if (!file) {
-                    info.error_message = "Cannot open file for reading";
-                    return info;
-                }
-                
-                // Step 6: Read efficiently in chunks
-                info.content.reserve(info.file_size); // Pre-allocate memory
-                
-                char buffer[CHUNK_SIZE];
-                while (file.read(buffer, CHUNK_SIZE) || file.gcount() > 0) {
-                    info.content.append(buffer, file.gcount());
-                }
-                
-                // Step 7: Detect MIME type from file extension
-                info.mime_type = MimeTypeDetector::get_mime_type(file_path);
-                
-                // Step 8: Mark as successful
-                info.success = true;
-                
-            } catch (const std::exception& e) {
-                info.error_message = "Error reading file: " + std::string(e.what());
-                info.success = false;
+        // Open `relative_path` beneath `root` for zero-copy delivery instead
+        // of reading it. The metadata comes from fstat() on the opened
+        // descriptor, so it always describes the file that will be sent. A
+        // path that would leave the root or cross a symlink is reported as
+        // not found.
+        static FileInfo open_file(const RootDirectory& root, const char* relative_path) {
+            return describe_open_file(root.open(relative_path), relative_path);
+        }
+        
+        // Tell the kernel a file is about to be read front to back: it
+        // doubles the readahead window, and on Linux the first
+        // READAHEAD_WINDOW bytes start loading into the page cache now, so
+        // the reads (or sendfile) that follow find them there
+        static void advise_sequential(const FileHandle& file, size_t length) {
+#if defined(__linux__)
+            posix_fadvise(file.fd(), 0, 0, POSIX_FADV_SEQUENTIAL);
+            readahead(file.fd(), 0, length < READAHEAD_WINDOW ? length : READAHEAD_WINDOW);
+#elif defined(__APPLE__)
+            (void)length;
+            fcntl(file.fd(), F_RDAHEAD, 1);
+#else
+            (void)file;
+            (void)length;
+#endif
+        }
+        
+        // Read `length` bytes of an already open file with pread(), without
+        // another open or stat
+        static bool read_contents(const FileHandle& file, size_t length, std::string& out) {
+            out.resize(length);
+            size_t done = 0;
+            while (done < length) {
+                ssize_t n = pread(file.fd(), &out[done], length - done, static_cast<off_t>(done));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                done += static_cast<size_t>(n);
             }
-            
-            return info;
+            return true;
         }
         
         static std::string format_http_date(std::chrono::system_clock::time_point time_point) {
-            // Convert to time_t for compatibility with C time functions
-            auto time_t = std::chrono::system_clock::to_time_t(time_point);
-            
-            // Convert to GMT (UTC) as required by HTTP spec
-            std::tm* gmt = std::gmtime(&time_t);
-            
-            // Format: "Wed, 21 Oct 2015 07:28:00 GMT"
-            char buffer[64];
-            std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", gmt);
-            return std::string(buffer);
+            // Format: "Wed, 21 Oct 2015 07:28:00 GMT", always in GMT as
+            // required by the HTTP spec
+            return UTILS::format_http_date(std::chrono::system_clock::to_time_t(time_point));
         }
         
-        static std::string generate_etag(size_t file_size, 
-                                       std::chrono::system_clock::time_point last_modified) {
-            // Convert timestamp to seconds since epoch
-            auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-                last_modified.time_since_epoch()).count();
-            
-            // ETag format: "size-timestamp" in quotes (quotes required by HTTP spec)
-            return "\"" + std::to_string(file_size) + "-" + std::to_string(timestamp) + "\"";
+        // Strong ETag from a hash of the content, so identical bytes get the
+        // same tag across restarts, touches and deploys that copy files
+        static std::string generate_etag(uint64_t content_hash) {
+            static constexpr char HEX[] = "0123456789abcdef";
+            std::string etag(18, '"');
+            for (int i = 0; i < 16; ++i) {
+                etag[1 + i] = HEX[(content_hash >> (60 - 4 * i)) & 0xF];
+            }
+            return etag;
+        }
+        
+        // XXH64 of the first `length` bytes of an open file, read in
+        // CHUNK_SIZE pieces with pread()
+        static bool hash_contents(const FileHandle& file, size_t length, uint64_t& hash) {
+            thread_local char buffer[CHUNK_SIZE];
+            XXHash64 state;
+            size_t done = 0;
+            while (done < length) {
+                size_t want = length - done < CHUNK_SIZE ? length - done : CHUNK_SIZE;
+                ssize_t n = pread(file.fd(), buffer, want, static_cast<off_t>(done));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                state.update(buffer, static_cast<size_t>(n));
+                done += static_cast<size_t>(n);
+            }
+            hash = state.digest();
+            return true;
         }
         
-        static std::string generate_cache_control(const std::string& mime_type) {
+        static std::string generate_cache_control(std::string_view mime_type) {
             if (MimeTypeDetector::is_cacheable(mime_type)) {
                 // Static assets can be cached for 1 hour
                 if (StringUtils::starts_with(mime_type, "image/") || 
@@ -127,10 +125,42 @@ namespace UTILS {
                 return "no-cache, must-revalidate";
             }
         }
-        
-        static bool should_use_sendfile(size_t file_size) {
-            // sendfile() has overhead, only worth it for files > 32KB
-            return file_size > 32 * 1024;
+
+    private:
+        // fstat() a freshly opened descriptor (or report why open failed)
+        static FileInfo describe_open_file(int fd, std::string_view file_path) {
+            FileInfo info;
+            
+            if (fd == -1) {
+                // Missing, forbidden or outside the root is a 404; anything
+                // else (EMFILE, EIO, ...) is a server error and must not be
+                // cached as missing
+                info.not_found = errno == ENOENT || errno == ENOTDIR || errno == EACCES ||
+                                 errno == ELOOP || errno == EXDEV;
+                info.error_message = "File not found or inaccessible";
+                return info;
+            }
+            auto handle = std::make_shared<const FileHandle>(fd);
+            
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) != 0) {
+                info.error_message = "File not found or inaccessible";
+                return info;
+            }
+            
+            if (!S_ISREG(file_stat.st_mode)) {
+                info.not_found = true;
+                info.error_message = "Not a regular file";
+                return info;
+            }
+            
+            info.last_modified = std::chrono::system_clock::time_point(
+                std::chrono::seconds(file_stat.st_mtime));
+            info.file_size = static_cast<size_t>(file_stat.st_size);
+            info.mime_type = MimeTypeDetector::get_mime_type(file_path);
+            info.handle = std::move(handle);
+            info.success = true;
+            return info;
         }
     };
 
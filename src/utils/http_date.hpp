@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace UTILS {
+
+    // Length of an IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    static constexpr size_t HTTP_DATE_LENGTH = 29;
+
+    // Render an IMF-fixdate into `out` (HTTP_DATE_LENGTH bytes, no NUL).
+    // Uses gmtime_r and fixed tables instead of strftime, which takes the
+    // locale lock and parses its format string on every call.
+    inline void format_http_date(std::time_t time, char* out) {
+        static constexpr char DAYS[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        static constexpr char MONTHS[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        std::tm gmt {};
+        gmtime_r(&time, &gmt);
+
+        auto two_digits = [](char* p, int value) {
+            p[0] = static_cast<char>('0' + value / 10);
+            p[1] = static_cast<char>('0' + value % 10);
+        };
+
+        int year = gmt.tm_year + 1900;
+        out[0] = DAYS[gmt.tm_wday][0];
+        out[1] = DAYS[gmt.tm_wday][1];
+        out[2] = DAYS[gmt.tm_wday][2];
+        out[3] = ',';
+        out[4] = ' ';
+        two_digits(out + 5, gmt.tm_mday);
+        out[7] = ' ';
+        out[8] = MONTHS[gmt.tm_mon][0];
+        out[9] = MONTHS[gmt.tm_mon][1];
+        out[10] = MONTHS[gmt.tm_mon][2];
+        out[11] = ' ';
+        two_digits(out + 12, year / 100 % 100);
+        two_digits(out + 14, year % 100);
+        out[16] = ' ';
+        two_digits(out + 17, gmt.tm_hour);
+        out[19] = ':';
+        two_digits(out + 20, gmt.tm_min);
+        out[22] = ':';
+        two_digits(out + 23, gmt.tm_sec);
+        out[25] = ' ';
+        out[26] = 'G';
+        out[27] = 'M';
+        out[28] = 'T';
+    }
+
+    inline std::string format_http_date(std::time_t time) {
+        std::string result(HTTP_DATE_LENGTH, '\0');
+        format_http_date(time, result.data());
+        return result;
+    }
+
+    // Parse an IMF-fixdate, the only form we send and the one every current
+    // client echoes back. The obsolete RFC 850 and asctime forms are not
+    // accepted; callers ignore a header whose date does not parse, as
+    // RFC 9110 allows.
+    inline bool parse_http_date(std::string_view text, std::time_t& out) {
+        static constexpr std::string_view MONTHS = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        if (text.size() != HTTP_DATE_LENGTH || text[3] != ',' || text[4] != ' ' || text[7] != ' ' ||
+            text[11] != ' ' || text[16] != ' ' || text[19] != ':' || text[22] != ':' ||
+            text.substr(25) != " GMT") {
+            return false;
+        }
+
+        auto digits = [&](size_t pos, size_t count, int& value) {
+            value = 0;
+            for (size_t i = pos; i < pos + count; ++i) {
+                if (text[i] < '0' || text[i] > '9') return false;
+                value = value * 10 + (text[i] - '0');
+            }
+            return true;
+        };
+
+        int day, year, hour, minute, second;
+        size_t month = MONTHS.find(text.substr(8, 3));
+        if (month == std::string_view::npos || month % 3 != 0 ||
+            !digits(5, 2, day) || !digits(12, 4, year) || !digits(17, 2, hour) ||
+            !digits(20, 2, minute) || !digits(23, 2, second) ||
+            day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+            return false;
+        }
+
+        // Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's
+        // days_from_civil), avoiding timegm() and the TZ machinery
+        int m = static_cast<int>(month / 3) + 1;
+        int y = year - (m <= 2);
+        int era = y / 400;
+        int year_of_era = y - era * 400;
+        int day_of_year = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        int64_t days = static_cast<int64_t>(era) * 146097 + day_of_era - 719468;
+
+        out = static_cast<std::time_t>(days * 86400 + hour * 3600 + minute * 60 + second);
+        return true;
+    }
+
+    // HttpDateClock holds the current Date header value. The reactor calls
+    // tick() whenever it wakes up; the string is re-rendered only when the
+    // second has changed, so workers read a ready value with no formatting
+    // and no lock.
+    //
+    // Two buffers are flipped on update. now() returns a view into the
+    // active one, which stays intact until the clock moves on twice, so
+    // callers should copy it right away (Headers::set does).
+    class HttpDateClock {
+    public:
+        static void tick() {
+            tick(std::time(nullptr));
+        }
+
+        static void tick(std::time_t now) {
+            State& s = state();
+            if (now == s.second.load(std::memory_order_relaxed)) {
+                return;
+            }
+            unsigned next = s.active.load(std::memory_order_relaxed) ^ 1u;
+            format_http_date(now, s.buffers[next]);
+            s.second.store(now, std::memory_order_relaxed);
+            s.active.store(next, std::memory_order_release);
+        }
+
+        static std::string_view now() {
+            const State& s = state();
+            return std::string_view(s.buffers[s.active.load(std::memory_order_acquire)],
+                                    HTTP_DATE_LENGTH);
+        }
+
+    private:
+        struct State {
+            char buffers[2][HTTP_DATE_LENGTH] {};
+            std::atomic<unsigned> active {0};
+            std::atomic<std::time_t> second {0};
+
+            State() {
+                std::time_t now = std::time(nullptr);
+                format_http_date(now, buffers[0]);
+                second.store(now, std::memory_order_relaxed);
+            }
+        };
+
+        static State& state() {
+            static State instance;
+            return instance;
+        }
+    };
+
+} // namespace UTILS
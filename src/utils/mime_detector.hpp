@@ -1,41 +1,104 @@
 #pragma once
 
 #include "string_utils.hpp"  
+#include "perfect_hash.hpp"
 
+#include <array>
 #include <string>
-#include <unordered_map>
-#include <algorithm>
 #include <string_view>
 
 namespace UTILS {
 
+    struct MimeEntry {
+        std::string_view extension;
+        std::string_view mime_type;
+    };
+
+    inline constexpr MimeEntry MIME_ENTRIES[] = {
+        // Web content - the core of what web servers serve
+        {"html", "text/html"},
+        {"htm",  "text/html"},
+        {"css",  "text/css"},
+        {"js",   "text/javascript"},
+        {"json", "application/json"},
+        {"xml",  "text/xml"},
+        {"txt",  "text/plain"},
+
+        // Images - probably the most common static files
+        {"jpg",  "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"png",  "image/png"},
+        {"gif",  "image/gif"},
+        {"bmp",  "image/bmp"},
+        {"webp", "image/webp"},
+        {"svg",  "image/svg+xml"},
+        {"ico",  "image/x-icon"},
+
+        // Fonts - increasingly important for modern web design
+        {"woff",  "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf",   "font/ttf"},
+        {"otf",   "font/otf"},
+        {"eot",   "application/vnd.ms-fontobject"},
+
+        // Documents - common file types users might serve
+        {"pdf",  "application/pdf"},
+        {"doc",  "application/msword"},
+        {"docx", "application/vnd.openxmlformats-officedocument.wordprocessingml.document"},
+        {"xls",  "application/vnd.ms-excel"},
+        {"xlsx", "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet"},
+
+        // Archives - for downloadable content
+        {"zip",  "application/zip"},
+        {"tar",  "application/x-tar"},
+        {"gz",   "application/gzip"},
+        {"7z",   "application/x-7z-compressed"},
+
+        // Media files - for rich content
+        {"mp3",  "audio/mpeg"},
+        {"mp4",  "video/mp4"},
+        {"avi",  "video/x-msvideo"},
+        {"mov",  "video/quicktime"},
+        {"wav",  "audio/wav"},
+        {"ogg",  "audio/ogg"}
+    };
+
+    inline constexpr size_t MIME_ENTRY_COUNT = sizeof(MIME_ENTRIES) / sizeof(MIME_ENTRIES[0]);
+
+    constexpr std::array<std::string_view, MIME_ENTRY_COUNT> mime_extension_keys() {
+        std::array<std::string_view, MIME_ENTRY_COUNT> keys {};
+        for (size_t i = 0; i < MIME_ENTRY_COUNT; ++i) {
+            keys[i] = MIME_ENTRIES[i].extension;
+        }
+        return keys;
+    }
+
+    // Built at compile time: extension -> index into MIME_ENTRIES
+    inline constexpr PerfectHashMap<MIME_ENTRY_COUNT, 256> MIME_EXTENSION_TABLE {mime_extension_keys()};
+
     class MimeTypeDetector {
     public:
 
-        static std::string get_mime_type(const std::string& file_path) {
+        static std::string_view get_mime_type(std::string_view file_path) {
             // Find the last dot in the filename to locate the extension
             size_t dot_pos = file_path.find_last_of('.');
-            if (dot_pos == std::string::npos) {
+            if (dot_pos == std::string_view::npos) {
                 // No extension found, return binary default
                 return "application/octet-stream";
             }
             
-            // Extract everything after the last dot and convert to lowercase
-            // This handles cases like "Photo.JPG" or "STYLE.CSS"
-            std::string extension = file_path.substr(dot_pos + 1);
-            std::transform(extension.begin(), extension.end(), 
-                         extension.begin(), ::tolower);
-            
-            auto it = mime_type_map.find(extension);
-            if (it != mime_type_map.end()) {
-                return it->second;
+            // Everything after the last dot, matched case-insensitively so
+            // "Photo.JPG" and "STYLE.CSS" resolve without lowercasing a copy
+            size_t index = MIME_EXTENSION_TABLE.find(file_path.substr(dot_pos + 1));
+            if (index != MIME_EXTENSION_TABLE.npos) {
+                return MIME_ENTRIES[index].mime_type;
             }
             
             // If we don't recognize the extension, return the generic binary type
             return "application/octet-stream";
         }
         
-        static bool is_cacheable(const std::string& mime_type) {
+        static bool is_cacheable(std::string_view mime_type) {
             // Images are almost always safe to cache
             if (StringUtils::starts_with(mime_type, "image/")) return true;
             
@@ -51,12 +114,23 @@ namespace UTILS {
             // Most other content (especially HTML) might be dynamic
             return false;
         }
-        
+
+        // Text-like types that shrink well with gzip. Images, fonts, audio
+        // and video are already compressed (svg being the exception).
+        static bool is_compressible(std::string_view mime_type) {
+            if (StringUtils::starts_with(mime_type, "text/")) return true;
+            if (StringUtils::starts_with(mime_type, "application/javascript")) return true;
+            if (StringUtils::starts_with(mime_type, "application/json")) return true;
+            if (StringUtils::starts_with(mime_type, "application/xml")) return true;
+            if (StringUtils::starts_with(mime_type, "image/svg+xml")) return true;
+            return false;
+        }
+
 
         // Gets a human-readable description of a MIME type.
         // Useful for logging, debugging, or user interfaces.
 
-        static std::string get_description(const std::string& mime_type) {
+        static std::string get_description(std::string_view mime_type) {
             if (StringUtils::starts_with(mime_type, "image/")) return "Image file";
             if (StringUtils::starts_with(mime_type, "text/html")) return "Web page";
             if (StringUtils::starts_with(mime_type, "text/css")) return "Stylesheet";
@@ -69,57 +143,6 @@ namespace UTILS {
             return "Binary file";
         }
 
-    private:
-        static const std::unordered_map<std::string, std::string> mime_type_map;
-    };
-
-    const std::unordered_map<std::string, std::string> MimeTypeDetector::mime_type_map = {
-        // Web content - the core of what web servers serve
-        {"html", "text/html"},
-        {"htm",  "text/html"},
-        {"css",  "text/css"},
-        {"js",   "text/javascript"},
-        {"json", "application/json"},
-        {"xml",  "text/xml"},
-        {"txt",  "text/plain"},
-        
-        // Images - probably the most common static files
-        {"jpg",  "image/jpeg"},
-        {"jpeg", "image/jpeg"},
-        {"png",  "image/png"},
-        {"gif",  "image/gif"},
-        {"bmp",  "image/bmp"},
-        {"webp", "image/webp"},
-        {"svg",  "image/svg+xml"},
-        {"ico",  "image/x-icon"},
-        
-        // Fonts - increasingly important for modern web design
-        {"woff",  "font/woff"},
-        {"woff2", "font/woff2"},
-        {"ttf",   "font/ttf"},
-        {"otf",   "font/otf"},
-        {"eot",   "application/vnd.ms-fontobject"},
-        
-        // Documents - common file types users might serve
-        {"pdf",  "application/pdf"},
-        {"doc",  "application/msword"},
-        {"docx", "application/vnd.openxmlformats-officedocument.wordprocessingml.document"},
-        {"xls",  "application/vnd.ms-excel"},
-        {"xlsx", "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet"},
-        
-        // Archives - for downloadable content
-        {"zip",  "application/zip"},
-        {"tar",  "application/x-tar"},
-        {"gz",   "application/gzip"},
-        {"7z",   "application/x-7z-compressed"},
-        
-        // Media files - for rich content
-        {"mp3",  "audio/mpeg"},
-        {"mp4",  "video/mp4"},
-        {"avi",  "video/x-msvideo"},
-        {"mov",  "video/quicktime"},
-        {"wav",  "audio/wav"},
-        {"ogg",  "audio/ogg"}
     };
 
 } // namespace UTILS
\ No newline at end of file
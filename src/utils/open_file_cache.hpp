@@ -0,0 +1,120 @@
+#pragma once
+
+#include "file_cache.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UTILS {
+
+    // OpenFileCache remembers, per resolved path, the open descriptor and
+    // stat-derived metadata of files too large for FileCache, plus negative
+    // entries for paths that do not exist. Like nginx's open_file_cache, a
+    // hit needs no open/stat/close, so serving a large file costs little
+    // more than the sendfile() itself.
+    //
+    // Entries expire after TTL and the table is bounded (LRU per shard).
+    // Each entry also records the FileCache generation it was created under;
+    // when inotify reports any change the generation moves and entries are
+    // treated as expired, so edits and newly created files are picked up
+    // right away instead of after the TTL.
+    class OpenFileCache {
+    public:
+        static constexpr size_t SHARD_COUNT = 8;
+        static constexpr size_t MAX_ENTRIES = 1024;
+        static constexpr std::chrono::seconds TTL{10};
+
+        // True if `path` is cached. `file` is then the entry, or null when
+        // the path is known not to exist.
+        bool find(const std::string& path, uint64_t generation,
+                  std::shared_ptr<const CachedFile>& file) {
+            Shard& shard = shard_for(path);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(path);
+            if (it == shard.entries.end()) {
+                return false;
+            }
+            if (it->second.generation != generation ||
+                std::chrono::steady_clock::now() >= it->second.expires) {
+                erase(shard, it);
+                return false;
+            }
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.position);
+            ++it->second.hits;
+            file = it->second.file;
+            return true;
+        }
+
+        // Cache `file` for `path`; pass null to record that it does not exist
+        void insert(const std::string& path, std::shared_ptr<const CachedFile> file,
+                    uint64_t generation) {
+            Shard& shard = shard_for(path);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto existing = shard.entries.find(path);
+            if (existing != shard.entries.end()) {
+                erase(shard, existing);
+            }
+            while (shard.entries.size() >= MAX_ENTRIES / SHARD_COUNT && !shard.lru.empty()) {
+                erase(shard, shard.entries.find(shard.lru.back()));
+            }
+            shard.lru.push_front(path);
+            shard.entries.emplace(path, Slot{std::move(file), shard.lru.begin(), generation,
+                                             std::chrono::steady_clock::now() + TTL});
+        }
+
+        size_t size() const {
+            size_t total = 0;
+            for (const Shard& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                total += shard.entries.size();
+            }
+            return total;
+        }
+
+        // Open files only; negative entries are not worth recording
+        void collect_hits(std::vector<PathHits>& out) const {
+            for (const Shard& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (const auto& [path, slot] : shard.entries) {
+                    if (slot.file) {
+                        out.push_back(PathHits{path, slot.hits});
+                    }
+                }
+            }
+        }
+
+    private:
+        struct Slot {
+            std::shared_ptr<const CachedFile> file;
+            std::list<std::string>::iterator position;
+            uint64_t generation;
+            std::chrono::steady_clock::time_point expires;
+            uint64_t hits = 0;
+        };
+
+        struct Shard {
+            mutable std::mutex mutex;
+            std::list<std::string> lru;   // Front is most recently used
+            std::unordered_map<std::string, Slot> entries;
+        };
+
+        Shard shards_[SHARD_COUNT];
+
+        Shard& shard_for(const std::string& path) {
+            return shards_[std::hash<std::string>{}(path) % SHARD_COUNT];
+        }
+
+        static void erase(Shard& shard, std::unordered_map<std::string, Slot>::iterator it) {
+            shard.lru.erase(it->second.position);
+            shard.entries.erase(it);
+        }
+    };
+
+} // namespace UTILS
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+namespace UTILS {
+
+    constexpr char ascii_lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // ASCII case-insensitive comparison (HTTP tokens are ASCII)
+    constexpr bool iequals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (ascii_lower(a[i]) != ascii_lower(b[i])) return false;
+        }
+        return true;
+    }
+
+    // PerfectHashMap maps a fixed set of keys to their index in the key array.
+    // The seed is searched for at compile time so that every key lands in its
+    // own slot; a lookup is then one hash, one array read and one compare,
+    // with no allocation. Declare instances as `inline constexpr` so the
+    // search never runs at startup.
+    //
+    // When the keys already differ in length or in their first, middle or
+    // last byte (methods, header names, file extensions), only those are
+    // hashed, so a lookup costs the same for long names as for short ones.
+    // Key sets that share all four (paths like /v1/a and /v2/a) hash every
+    // byte instead.
+    //
+    // TableSize must be a power of two; keep it at least ~3x the key count
+    // or the seed search gets expensive (it fails to compile if no seed fits).
+    template <size_t N, size_t TableSize, bool CaseInsensitive = true>
+    class PerfectHashMap {
+        static_assert((TableSize & (TableSize - 1)) == 0, "TableSize must be a power of two");
+        static_assert(TableSize >= N, "TableSize must be able to hold every key");
+        static_assert(N < UINT16_MAX, "too many keys");
+
+    public:
+        static constexpr size_t npos = N;
+        static constexpr uint32_t MAX_SEED_ATTEMPTS = 100000;
+
+        constexpr explicit PerfectHashMap(const std::array<std::string_view, N>& keys)
+            : keys_(keys) {
+            sampled_ = samples_differ();
+            if (search_seed()) return;
+            sampled_ = false;
+            if (search_seed()) return;
+            throw std::logic_error("PerfectHashMap: no collision-free seed found");
+        }
+
+        // Index of key in the original array, or npos if it is not a member.
+        // A key in its canonical spelling matches with one memcmp.
+        constexpr size_t find(std::string_view key) const {
+            uint16_t slot = slots_[hash(key, seed_) & (TableSize - 1)];
+            if (slot == 0) return npos;
+            std::string_view candidate = keys_[slot - 1];
+            bool match = candidate == key || (CaseInsensitive && iequals(candidate, key));
+            return match ? slot - 1 : npos;
+        }
+
+        constexpr std::string_view key(size_t index) const { return keys_[index]; }
+        constexpr size_t size() const { return N; }
+
+    private:
+        std::array<std::string_view, N> keys_;
+        std::array<uint16_t, TableSize> slots_ {};
+        uint32_t seed_ = 0;
+        bool sampled_ = false;
+
+        constexpr bool search_seed() {
+            for (uint32_t seed = 1; seed < MAX_SEED_ATTEMPTS; ++seed) {
+                std::array<uint16_t, TableSize> trial {};
+                bool collision = false;
+                for (size_t i = 0; i < N && !collision; ++i) {
+                    uint16_t& slot = trial[hash(keys_[i], seed) & (TableSize - 1)];
+                    if (slot != 0) {
+                        collision = true;
+                    } else {
+                        slot = static_cast<uint16_t>(i + 1);
+                    }
+                }
+                if (!collision) {
+                    slots_ = trial;
+                    seed_ = seed;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Whether no two keys agree in length and first, middle and last
+        // byte, so hashing just those can tell every key apart
+        constexpr bool samples_differ() const {
+            for (size_t i = 0; i < N; ++i) {
+                for (size_t j = i + 1; j < N; ++j) {
+                    if (sample(keys_[i]) == sample(keys_[j])) return false;
+                }
+            }
+            return true;
+        }
+
+        static constexpr uint8_t fold(char c) {
+            return static_cast<uint8_t>(CaseInsensitive ? ascii_lower(c) : c);
+        }
+
+        static constexpr uint64_t sample(std::string_view key) {
+            if (key.empty()) return 0;
+            return (static_cast<uint64_t>(key.size()) << 24) | (fold(key.front()) << 16) |
+                   (fold(key[key.size() / 2]) << 8) | fold(key.back());
+        }
+
+        // Seeded FNV-1a over the sampled bytes or the whole key, with a
+        // final avalanche step
+        constexpr uint32_t hash(std::string_view key, uint32_t seed) const {
+            uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+            if (sampled_) {
+                uint64_t bits = sample(key);
+                h ^= static_cast<uint32_t>(bits);
+                h *= 16777619u;
+                h ^= static_cast<uint32_t>(bits >> 32);
+                h *= 16777619u;
+            } else {
+                for (char c : key) {
+                    h ^= fold(c);
+                    h *= 16777619u;
+                }
+            }
+            h ^= h >> 15;
+            h *= 0x2C1B3C6Du;
+            h ^= h >> 12;
+            return h;
+        }
+    };
+
+} // namespace UTILS
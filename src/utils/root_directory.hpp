@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+    #include <sys/syscall.h>
+    #if defined(SYS_openat2) && __has_include(<linux/openat2.h>)
+        #include <linux/openat2.h>
+        #define SPP_HAVE_OPENAT2 1
+    #endif
+#endif
+
+namespace UTILS {
+
+    // RootDirectory keeps a descriptor for the document root and opens
+    // files relative to it, so no request can reach a file outside the
+    // root, whatever the path string says.
+    //
+    // On Linux 5.6+ this is one openat2() with RESOLVE_BENEATH |
+    // RESOLVE_NO_SYMLINKS: the kernel rejects ".." escapes, absolute paths
+    // and any symlink along the way (EXDEV / ELOOP). Elsewhere, or on older
+    // kernels (ENOSYS), the path is walked one component at a time with
+    // O_NOFOLLOW, which gives the same guarantee at one openat() per
+    // component.
+    class RootDirectory {
+    public:
+        explicit RootDirectory(const std::string& path)
+            : fd_(::open(path.c_str(), DIRECTORY_FLAGS | O_CLOEXEC)) {}
+
+        ~RootDirectory() {
+            if (fd_ != -1) {
+                close(fd_);
+            }
+        }
+
+        RootDirectory(const RootDirectory&) = delete;
+        RootDirectory& operator=(const RootDirectory&) = delete;
+
+        bool valid() const { return fd_ != -1; }
+
+        // Open `relative` (no leading '/') read-only. Returns the new fd, or
+        // -1 with errno set.
+        int open(const char* relative) const {
+            if (fd_ == -1) {
+                errno = EBADF;
+                return -1;
+            }
+#ifdef SPP_HAVE_OPENAT2
+            if (openat2_supported().load(std::memory_order_relaxed)) {
+                open_how how {};
+                how.flags = O_RDONLY | O_CLOEXEC;
+                how.resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS;
+                int fd;
+                do {
+                    fd = static_cast<int>(syscall(SYS_openat2, fd_, relative, &how, sizeof(how)));
+                } while (fd == -1 && errno == EAGAIN); // Raced a rename; the kernel asks us to retry
+                if (fd != -1 || errno != ENOSYS) {
+                    return fd;
+                }
+                openat2_supported().store(false, std::memory_order_relaxed);
+            }
+#endif
+            return open_walking(relative);
+        }
+
+    private:
+        // A directory is opened only to resolve names beneath it: O_PATH
+        // where there is one. Elsewhere a read-only open stands in, which
+        // needs read permission on the directory; O_DIRECTORY fails it
+        // before it could ever block on a FIFO.
+#ifdef O_PATH
+        static constexpr int DIRECTORY_FLAGS = O_PATH | O_DIRECTORY;
+#else
+        static constexpr int DIRECTORY_FLAGS = O_RDONLY | O_DIRECTORY;
+#endif
+
+        int fd_;
+
+#ifdef SPP_HAVE_OPENAT2
+        static std::atomic<bool>& openat2_supported() {
+            static std::atomic<bool> supported{true};
+            return supported;
+        }
+#endif
+
+        // Descend one directory at a time, refusing symlinks at every step
+        int open_walking(const char* relative) const {
+            std::string_view rest = relative;
+            thread_local std::string component;
+
+            int dir = fd_;
+            while (true) {
+                size_t slash = rest.find('/');
+                component.assign(rest.substr(0, slash));
+                if (component.empty() || component == "..") {
+                    if (dir != fd_) close(dir);
+                    errno = component.empty() ? ENOENT : EXDEV;
+                    return -1;
+                }
+
+                bool last = slash == std::string_view::npos;
+                int flags = last ? (O_RDONLY | O_NOFOLLOW | O_CLOEXEC)
+                                 : (DIRECTORY_FLAGS | O_NOFOLLOW | O_CLOEXEC);
+                int next = openat(dir, component.c_str(), flags);
+                int saved = errno;
+                if (dir != fd_) close(dir);
+                if (next == -1 || last) {
+                    errno = saved;
+                    return next;
+                }
+                dir = next;
+                rest.remove_prefix(slash + 1);
+            }
+        }
+    };
+
+} // namespace UTILS
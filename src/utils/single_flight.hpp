@@ -0,0 +1,49 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UTILS {
+
+    // SingleFlight lets concurrent callers with the same key share one
+    // piece of work. The first to join() a key becomes its leader and does
+    // the work; the rest leave a Waiter behind and return at once, without
+    // blocking their thread. When the leader is done it calls finish(),
+    // which closes the flight and hands back the waiters to complete with
+    // its result. A join() after finish() starts a new flight.
+    template <typename Waiter>
+    class SingleFlight {
+    public:
+        // True if `waiter` was queued behind a flight already running;
+        // false if the caller is now the leader for `key` (and `waiter`
+        // is left untouched)
+        bool join(const std::string& key, Waiter&& waiter) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto [flight, started] = flights_.try_emplace(key);
+            if (started) {
+                return false;
+            }
+            flight->second.push_back(std::move(waiter));
+            return true;
+        }
+
+        // End the flight for `key`, returning whoever waited on it
+        std::vector<Waiter> finish(const std::string& key) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto flight = flights_.find(key);
+            if (flight == flights_.end()) {
+                return {};
+            }
+            std::vector<Waiter> waiters = std::move(flight->second);
+            flights_.erase(flight);
+            return waiters;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::vector<Waiter>> flights_;
+    };
+
+} // namespace UTILS
@@ -178,6 +178,48 @@ namespace UTILS {
             
             return result;
         }
+        
+        /**
+         * Appends `encoded` to `out` with %XX escapes decoded; the one
+         * percent-decoder for request paths and form/query data alike.
+         * '+' becomes a space only with `plus_is_space` (form data); in a
+         * path it is a literal '+'. Malformed escapes (a '%' not followed
+         * by two hex digits) are copied through as-is.
+         * 
+         * Writes straight into `out`, so with a reused buffer this does
+         * not allocate.
+         * 
+         * Examples:
+         *   "a%20b+c"        → "a b+c"
+         *   "a%20b+c", true  → "a b c"
+         *   "100%"           → "100%"
+         */
+        static void append_url_decoded(std::string_view encoded, std::string& out, bool plus_is_space = false) {
+            size_t start = out.size();
+            out.resize(start + encoded.size()); // Decoding never grows the text
+            char* dest = &out[start];
+            
+            for (size_t i = 0; i < encoded.size(); ++i) {
+                char c = encoded[i];
+                int high, low;
+                if (c == '%' && i + 2 < encoded.size() &&
+                    (high = hex_value(encoded[i + 1])) >= 0 && (low = hex_value(encoded[i + 2])) >= 0) {
+                    *dest++ = static_cast<char>(high * 16 + low);
+                    i += 2;
+                } else {
+                    *dest++ = (c == '+' && plus_is_space) ? ' ' : c;
+                }
+            }
+            out.resize(static_cast<size_t>(dest - out.data()));
+        }
+        
+    private:
+        static int hex_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
     };
 
 } // namespace UTILS
\ No newline at end of file
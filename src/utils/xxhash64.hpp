@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace UTILS {
+
+    // XXH64 (github.com/Cyan4973/xxHash), a non-cryptographic hash that runs
+    // at memory bandwidth. Used for content ETags, where we need a stable
+    // fingerprint of the bytes, not resistance to deliberate collisions.
+    // Output matches the reference implementation on little-endian hosts.
+    //
+    // Feed data with update() in pieces of any size, then call digest();
+    // hash() does both for a single buffer.
+    class XXHash64 {
+    public:
+        explicit XXHash64(uint64_t seed = 0) {
+            acc_[0] = seed + PRIME1 + PRIME2;
+            acc_[1] = seed + PRIME2;
+            acc_[2] = seed;
+            acc_[3] = seed - PRIME1;
+            seed_ = seed;
+        }
+
+        static uint64_t hash(const void* data, size_t length, uint64_t seed = 0) {
+            XXHash64 state(seed);
+            state.update(data, length);
+            return state.digest();
+        }
+
+        static uint64_t hash(std::string_view data, uint64_t seed = 0) {
+            return hash(data.data(), data.size(), seed);
+        }
+
+        void update(const void* data, size_t length) {
+            const auto* p = static_cast<const unsigned char*>(data);
+            total_length_ += length;
+
+            // Top up a partial stripe left by the previous call
+            if (buffered_ > 0) {
+                size_t take = STRIPE - buffered_ < length ? STRIPE - buffered_ : length;
+                std::memcpy(buffer_ + buffered_, p, take);
+                buffered_ += take;
+                p += take;
+                length -= take;
+                if (buffered_ < STRIPE) {
+                    return;
+                }
+                consume_stripe(buffer_);
+                buffered_ = 0;
+            }
+
+            while (length >= STRIPE) {
+                consume_stripe(p);
+                p += STRIPE;
+                length -= STRIPE;
+            }
+
+            std::memcpy(buffer_, p, length);
+            buffered_ = length;
+        }
+
+        uint64_t digest() const {
+            uint64_t h;
+            if (total_length_ >= STRIPE) {
+                h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+                for (uint64_t acc : acc_) {
+                    h = merge_round(h, acc);
+                }
+            } else {
+                h = seed_ + PRIME5;
+            }
+            h += total_length_;
+
+            const unsigned char* p = buffer_;
+            size_t length = buffered_;
+            while (length >= 8) {
+                h ^= round(0, read64(p));
+                h = rotl(h, 27) * PRIME1 + PRIME4;
+                p += 8;
+                length -= 8;
+            }
+            if (length >= 4) {
+                h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+                h = rotl(h, 23) * PRIME2 + PRIME3;
+                p += 4;
+                length -= 4;
+            }
+            while (length > 0) {
+                h ^= static_cast<uint64_t>(*p) * PRIME5;
+                h = rotl(h, 11) * PRIME1;
+                ++p;
+                --length;
+            }
+
+            h ^= h >> 33;
+            h *= PRIME2;
+            h ^= h >> 29;
+            h *= PRIME3;
+            h ^= h >> 32;
+            return h;
+        }
+
+    private:
+        static constexpr uint64_t PRIME1 = 11400714785074694791ULL;
+        static constexpr uint64_t PRIME2 = 14029467366897019727ULL;
+        static constexpr uint64_t PRIME3 = 1609587929392839161ULL;
+        static constexpr uint64_t PRIME4 = 9650029242287828579ULL;
+        static constexpr uint64_t PRIME5 = 2870177450012600261ULL;
+        static constexpr size_t STRIPE = 32;
+
+        uint64_t acc_[4];
+        uint64_t seed_;
+        uint64_t total_length_ = 0;
+        unsigned char buffer_[STRIPE];
+        size_t buffered_ = 0;
+
+        static uint64_t rotl(uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        static uint64_t read64(const unsigned char* p) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static uint32_t read32(const unsigned char* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static uint64_t round(uint64_t acc, uint64_t input) {
+            acc += input * PRIME2;
+            acc = rotl(acc, 31);
+            return acc * PRIME1;
+        }
+
+        static uint64_t merge_round(uint64_t acc, uint64_t value) {
+            acc ^= round(0, value);
+            return acc * PRIME1 + PRIME4;
+        }
+
+        void consume_stripe(const unsigned char* p) {
+            acc_[0] = round(acc_[0], read64(p));
+            acc_[1] = round(acc_[1], read64(p + 8));
+            acc_[2] = round(acc_[2], read64(p + 16));
+            acc_[3] = round(acc_[3], read64(p + 24));
+        }
+    };
+
+} // namespace UTILS
@@ -0,0 +1,232 @@
+// JSON parser: the grammar edge cases RFC 8259 pins down (numbers,
+// escapes and surrogate pairs, UTF-8, trailing commas and content, the
+// nesting limit), strings that cross the 64-byte blocks the structural
+// indexer works in, and validation without a DOM agreeing with a full
+// parse on every input.
+//
+// Build and run with `make unit-test`.
+
+#include "core/json.hpp"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    int failures = 0;
+
+    #define CHECK(condition, ...)                                         \
+        do {                                                              \
+            if (!(condition)) {                                           \
+                ++failures;                                               \
+                std::fprintf(stderr, "%s:%d: CHECK(%s) failed: ",         \
+                             __FILE__, __LINE__, #condition);             \
+                std::fprintf(stderr, __VA_ARGS__);                        \
+                std::fputc('\n', stderr);                                 \
+            }                                                             \
+        } while (0)
+
+    // Printable form of a test input for failure messages
+    std::string shown(std::string_view text) {
+        std::string out;
+        for (unsigned char c : text.substr(0, 80)) {
+            if (c >= 0x20 && c < 0x7F) {
+                out += static_cast<char>(c);
+            } else {
+                char hex[8];
+                std::snprintf(hex, sizeof(hex), "\\x%02X", c);
+                out += hex;
+            }
+        }
+        return text.size() > 80 ? out + "..." : out;
+    }
+
+    // Parse `text`, checking that validation alone reaches the same verdict
+    bool parses(CORE::JsonDocument& document, std::string_view text) {
+        bool built = document.parse(text);
+        std::string error;
+        bool validated = CORE::JsonDocument::validate(text, error);
+        CHECK(built == validated, "parse says %d, validate says %d for %s", built, validated, shown(text).c_str());
+        CHECK(built || !document.error().empty(), "rejected without an error for %s", shown(text).c_str());
+        return built;
+    }
+
+    void accepts(std::string_view text) {
+        CORE::JsonDocument document;
+        CHECK(parses(document, text), "rejected %s: %s", shown(text).c_str(), document.error().c_str());
+    }
+
+    void rejects(std::string_view text) {
+        CORE::JsonDocument document;
+        CHECK(!parses(document, text), "accepted %s", shown(text).c_str());
+    }
+
+    // The one string in `text`, a JSON string literal
+    std::string string_value(std::string_view text) {
+        CORE::JsonDocument document;
+        if (!parses(document, text)) return "<rejected: " + document.error() + ">";
+        return std::string(document.root().as_string("<not a string>"));
+    }
+
+    void test_numbers() {
+        struct Integer {
+            const char* text;
+            int64_t value;
+        };
+        const Integer integers[] = {
+            {"0", 0}, {"-0", 0}, {"7", 7}, {"-42", -42},
+            {"123456789012345678", 123456789012345678}, {"-999999999999999999", -999999999999999999},
+        };
+        for (const Integer& integer : integers) {
+            CORE::JsonDocument document;
+            CHECK(parses(document, integer.text) && document.root().is_integer() &&
+                      document.root().as_int() == integer.value,
+                  "%s", integer.text);
+        }
+
+        struct Real {
+            const char* text;
+            double value;
+        };
+        const Real reals[] = {
+            {"1.5", 1.5}, {"-0.25", -0.25}, {"1e3", 1000}, {"1E+2", 100}, {"2.5e-3", 0.0025},
+            {"0.0", 0}, {"1234567890123456789", 1234567890123456789.0},
+        };
+        for (const Real& real : reals) {
+            CORE::JsonDocument document;
+            CHECK(parses(document, real.text) && document.root().is_number() &&
+                      !document.root().is_integer() && document.root().as_number() == real.value,
+                  "%s -> %.17g", real.text, document.root().as_number());
+        }
+
+        CORE::JsonDocument document;
+        CHECK(parses(document, "[1,-2.5e1,3]") && document.root()[1].as_number() == -25,
+              "number inside an array");
+
+        const char* const invalid[] = {
+            "01", "-01", "00", "-", "+1", ".5", "1.", "-.5", "1e", "1e+", "1E-", "0x10",
+            "1.2.3", "--1", "1a", "1 2", "NaN", "Infinity", "-Infinity", "[1.]", "[01]", "{\"a\":-}",
+        };
+        for (const char* text : invalid) {
+            rejects(text);
+        }
+    }
+
+    void test_escapes_and_surrogates() {
+        CHECK(string_value(R"("plain")") == "plain", "plain string");
+        CHECK(string_value(R"("")") == "", "empty string");
+        CHECK(string_value(R"("a\"b\\c\/d")") == "a\"b\\c/d", "quote, backslash and slash escapes");
+        CHECK(string_value(R"("\b\f\n\r\t")") == "\b\f\n\r\t", "control escapes");
+        CHECK(string_value(R"("\u0041\u00e9\u20AC")") == "A\xC3\xA9\xE2\x82\xAC", "\\u escapes of 1 to 3 bytes");
+        CHECK(string_value(R"("\u0000")") == std::string(1, '\0'), "escaped NUL");
+        CHECK(string_value(R"("\ud83d\uDE00")") == "\xF0\x9F\x98\x80", "surrogate pair");
+        CHECK(string_value(R"("\uDBFF\udfff")") == "\xF4\x8F\xBF\xBF", "highest code point");
+        CHECK(string_value(R"("x\\")") == "x\\", "escaped backslash before the closing quote");
+
+        const char* const invalid[] = {
+            R"("\x")", R"("\u12G4")", R"("\u123")", R"("\ud83d")", R"("\ud83dx")",
+            R"("\ud83dA")", R"("\ude00")", R"("\ude00\ud83d")", R"("abc\")", R"("abc)",
+            "\"tab\there\"", "\"line\nbreak\"", "\"nul\x01\"",
+        };
+        for (const char* text : invalid) {
+            rejects(text);
+        }
+    }
+
+    void test_utf8() {
+        CHECK(string_value("\"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80\"") == "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80",
+              "2, 3 and 4 byte sequences");
+        accepts("{\"\xC3\xA9\":\"\xF4\x8F\xBF\xBF\"}");
+
+        const char* const invalid[] = {
+            "\"\xC0\xAF\"",          // Overlong '/'
+            "\"\xE0\x80\xAF\"",      // Overlong, 3 bytes
+            "\"\xED\xA0\x80\"",      // Encoded surrogate
+            "\"\xF4\x90\x80\x80\"",  // Above U+10FFFF
+            "\"\xE2\x82\"",          // Truncated
+            "\"\x80\"",              // Stray continuation byte
+            "\"\xFF\"",
+            "\"\xC3\"",              // Lead byte then the closing quote
+        };
+        for (const char* text : invalid) {
+            rejects(text);
+        }
+        rejects(std::string_view("[1]\xC3", 4));
+    }
+
+    void test_structure() {
+        CORE::JsonDocument document;
+        CHECK(parses(document, " {\"a\" : [true, false, null], \"b\": {}, \"c\": []} \n") &&
+                  document.root().size() == 3 && document.root()["a"][0].as_bool() &&
+                  document.root()["a"][2].is_null() && document.root()["b"].is_object() &&
+                  document.root()["c"].is_array() && document.root()["missing"].is_null(),
+              "nested object");
+        CHECK(document.root().member(1).key == "b", "members keep document order");
+
+        accepts("true");
+        accepts("null");
+        accepts("\"top-level string\"");
+
+        const char* const invalid[] = {
+            "", "   ", "[1,]", "[,1]", "[1,,2]", "{\"a\":1,}", "{,}", "{\"a\"}", "{\"a\":}",
+            "{\"a\" 1}", "{1:2}", "{'a':1}", "[1 2]", "[1] [2]", "{} x", "1,", "[1]]", "[[1]",
+            "{\"a\":1", "tru", "truex", "nul", "True", "[true false]", "]", "}", ":",
+        };
+        for (const char* text : invalid) {
+            rejects(text);
+        }
+    }
+
+    void test_depth_limit() {
+        size_t limit = CORE::JsonParser::MAX_DEPTH;
+        accepts(std::string(limit, '[') + std::string(limit, ']'));
+        rejects(std::string(limit + 1, '[') + std::string(limit + 1, ']'));
+
+        std::string objects;
+        for (size_t i = 0; i < limit; ++i) objects += "{\"a\":";
+        accepts(objects + "1" + std::string(limit, '}'));
+        rejects("{\"a\":" + objects + "1" + std::string(limit + 1, '}'));
+
+        // A deep document that is otherwise fine must not be mistaken for
+        // a shallow one because its brackets are unbalanced
+        rejects(std::string(limit, '[') + std::string(limit - 1, ']'));
+    }
+
+    // The structural indexer classifies 64-byte blocks at a time; quotes,
+    // escapes and backslash runs must be tracked across block edges
+    void test_block_boundaries() {
+        for (size_t pad = 50; pad < 140; ++pad) {
+            std::string filler(pad, 'a');
+            std::string expected = filler + "\"q\\";
+            std::string text = "[\"" + filler + R"(\"q\\",1])";
+            CORE::JsonDocument document;
+            CHECK(parses(document, text) && document.root().size() == 2 &&
+                      document.root()[0].as_string() == expected && document.root()[1].as_int() == 1,
+                  "escapes at offset %zu", pad);
+
+            // An escaped quote must not end the string, even at a block edge
+            rejects("[\"" + filler + "\\\"]");
+            // Nor may structural characters inside a string count
+            std::string inside = "[\"" + filler + "],[{\"]";
+            CHECK(parses(document, inside) && document.root().size() == 1, "brackets in a string at offset %zu", pad);
+        }
+    }
+
+} // namespace
+
+int main() {
+    test_numbers();
+    test_escapes_and_surrogates();
+    test_utf8();
+    test_structure();
+    test_depth_limit();
+    test_block_boundaries();
+
+    if (failures) {
+        std::fprintf(stderr, "json_test: %d failure(s)\n", failures);
+        return 1;
+    }
+    std::printf("json_test: ok\n");
+    return 0;
+}
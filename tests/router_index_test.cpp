@@ -0,0 +1,316 @@
+// Router: thousands of generated static routes must all resolve to their
+// own controller through the exact-path index, near misses must not
+// resolve, and XXH64 must spread the set so lookups stay within a probe or
+// two. The radix tree behind it must rank static text over ":param" over
+// "*wildcard", backtrack out of dead ends, fill Request::param, and reject
+// patterns it could never match.
+//
+// Build and run with `make unit-test`.
+
+#include "core/router.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+    int failures = 0;
+
+    #define CHECK(condition, ...)                                         \
+        do {                                                              \
+            if (!(condition)) {                                           \
+                ++failures;                                               \
+                std::fprintf(stderr, "%s:%d: CHECK(%s) failed: ",         \
+                             __FILE__, __LINE__, #condition);             \
+                std::fprintf(stderr, __VA_ARGS__);                        \
+                std::fputc('\n', stderr);                                 \
+            }                                                             \
+        } while (0)
+
+    // Answers with its own id, so a hit shows which route matched
+    class IdController : public CORE::Controller {
+    public:
+        explicit IdController(int id) : id_(id) {}
+
+        void handle(const CORE::Request&, CORE::Response& res) override {
+            res.status_code = 200;
+            res.body = std::to_string(id_);
+        }
+
+    private:
+        int id_;
+    };
+
+    constexpr int ROUTE_COUNT = 10000;
+
+    // Route shapes seen in real APIs: shared prefixes, numeric ids in the
+    // middle, file names, versioned paths
+    std::vector<std::string> generate_paths() {
+        static const char* const SHAPES[] = {
+            "/api/v1/users/%d/profile",
+            "/api/v2/orders/%d",
+            "/static/js/chunk-%d.js",
+            "/assets/img/icon_%d.png",
+            "/docs/section-%d/index.html",
+        };
+        std::vector<std::string> paths;
+        paths.reserve(ROUTE_COUNT);
+        char buffer[64];
+        for (int i = 0; i < ROUTE_COUNT; ++i) {
+            std::snprintf(buffer, sizeof(buffer), SHAPES[i % 5], i / 5);
+            paths.emplace_back(buffer);
+        }
+        return paths;
+    }
+
+    bool route(const CORE::RouteSnapshot& routes, CORE::Method method, const std::string& path,
+               std::string& body) {
+        CORE::Request req;
+        req.method = std::string(CORE::method_name(method));
+        req.method_id = method;
+        req.path = path;
+        CORE::Response res;
+        bool found = routes.route(req, res);
+        body = res.body;
+        return found;
+    }
+
+    // Route `path` as a GET; the matched controller's id, or "none"
+    std::string route_get(const CORE::RouteSnapshot& routes, const std::string& path, CORE::Request& req) {
+        req = CORE::Request{};
+        req.method = "GET";
+        req.method_id = CORE::Method::GET;
+        req.path = path;
+        CORE::Response res;
+        return routes.route(req, res) ? res.body : "none";
+    }
+
+    std::string route_get(const CORE::RouteSnapshot& routes, const std::string& path) {
+        CORE::Request req;
+        return route_get(routes, path, req);
+    }
+
+    template <typename Fn>
+    bool throws_logic_error(Fn&& fn) {
+        try {
+            fn();
+        } catch (const std::logic_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    void test_every_route_resolves(const CORE::RouteSnapshot& routes, const std::vector<std::string>& paths) {
+        std::string body;
+        for (int i = 0; i < ROUTE_COUNT; ++i) {
+            bool found = route(routes, CORE::Method::GET, paths[i], body);
+            CHECK(found && body == std::to_string(i), "%s -> %s", paths[i].c_str(),
+                  found ? body.c_str() : "no route");
+            if (found) {
+                found = route(routes, CORE::Method::GET, paths[i] + "?page=2&sort=asc", body);
+                CHECK(found && body == std::to_string(i), "%s with a query -> %s", paths[i].c_str(),
+                      found ? body.c_str() : "no route");
+            }
+        }
+    }
+
+    void test_near_misses(const CORE::RouteSnapshot& routes, const std::vector<std::string>& paths) {
+        std::unordered_set<std::string> registered(paths.begin(), paths.end());
+        std::string body;
+        for (int i = 0; i < ROUTE_COUNT; i += 7) {
+            const std::string& path = paths[i];
+            std::string upper = path;
+            upper[1] = static_cast<char>(upper[1] - 'a' + 'A');
+            const std::string misses[] = {
+                path + "x",
+                path + "/",
+                path.substr(0, path.size() - 1),
+                upper,
+            };
+            for (const std::string& miss : misses) {
+                if (registered.count(miss)) continue; // "/orders/10" cut short is "/orders/1"
+                CHECK(!route(routes, CORE::Method::GET, miss, body), "%s matched %s", miss.c_str(), body.c_str());
+            }
+            CHECK(!route(routes, CORE::Method::DELETE, path, body), "DELETE %s matched", path.c_str());
+        }
+        CHECK(!route(routes, CORE::Method::GET, "/", body), "/ matched");
+        CHECK(!route(routes, CORE::Method::GET, "", body), "empty path matched");
+    }
+
+    void test_methods_are_separate(CORE::RouteSnapshot& routes, const std::vector<std::string>& paths) {
+        routes.add_route("POST", paths[42], std::make_shared<IdController>(-42));
+        std::string body;
+        CHECK(route(routes, CORE::Method::GET, paths[42], body) && body == "42", "GET -> %s", body.c_str());
+        CHECK(route(routes, CORE::Method::POST, paths[42], body) && body == "-42", "POST -> %s", body.c_str());
+    }
+
+    void test_collision_quality(const CORE::RouteSnapshot& routes, const std::vector<std::string>& paths) {
+        std::unordered_set<uint64_t> hashes;
+        for (const std::string& path : paths) {
+            hashes.insert(UTILS::XXHash64::hash(path));
+        }
+        CHECK(hashes.size() == paths.size(), "%zu 64-bit hash collisions",
+              paths.size() - hashes.size());
+
+        CORE::RouteSnapshot::IndexStats stats = routes.index_stats();
+        std::printf("  %zu routes in %zu slots: average probe %.2f, longest %zu\n",
+                    stats.entries, stats.slots, stats.average_probe, stats.longest_probe);
+        CHECK(stats.entries == paths.size(), "%zu entries", stats.entries);
+        CHECK(stats.unreachable == 0, "%zu indexed paths not found by lookup", stats.unreachable);
+        CHECK(stats.entries * 2 <= stats.slots, "more than half full: %zu of %zu", stats.entries, stats.slots);
+        // Linear probing at this load averages about 1.2 with a good hash
+        // and degrades quickly with a weak one
+        CHECK(stats.average_probe < 1.5, "average probe %.2f", stats.average_probe);
+        CHECK(stats.longest_probe <= 16, "longest probe %zu", stats.longest_probe);
+    }
+
+    void test_precedence_ignores_insertion_order() {
+        struct Pattern {
+            const char* path;
+            int id;
+        };
+        Pattern patterns[] = {{"/files/report", 1}, {"/files/:name", 2}, {"/files/*rest", 3}};
+        std::sort(std::begin(patterns), std::end(patterns),
+                  [](const Pattern& a, const Pattern& b) { return a.id < b.id; });
+        do {
+            CORE::RouteSnapshot routes;
+            for (const Pattern& pattern : patterns) {
+                routes.add_route("GET", pattern.path, std::make_shared<IdController>(pattern.id));
+            }
+            std::string order = std::string(patterns[0].path) + ", " + patterns[1].path + ", " + patterns[2].path;
+            CORE::Request req;
+            CHECK(route_get(routes, "/files/report", req) == "1", "static lost with %s", order.c_str());
+            CHECK(route_get(routes, "/files/summary", req) == "2" && req.param("name") == "summary",
+                  "param lost with %s", order.c_str());
+            CHECK(route_get(routes, "/files/2024/q1.pdf", req) == "3" && req.param("rest") == "2024/q1.pdf",
+                  "wildcard lost with %s", order.c_str());
+            CHECK(route_get(routes, "/files/report/old", req) == "3" && req.param("rest") == "report/old",
+                  "deeper path missed the wildcard with %s", order.c_str());
+        } while (std::next_permutation(std::begin(patterns), std::end(patterns),
+                                       [](const Pattern& a, const Pattern& b) { return a.id < b.id; }));
+    }
+
+    void test_backtracking() {
+        CORE::RouteSnapshot routes;
+        routes.add_route("GET", "/users/me/settings", std::make_shared<IdController>(1));
+        routes.add_route("GET", "/users/:id/x", std::make_shared<IdController>(2));
+        routes.add_route("GET", "/users/:id/posts/:post", std::make_shared<IdController>(3));
+        routes.add_route("GET", "/users/me/posts/latest", std::make_shared<IdController>(4));
+
+        CORE::Request req;
+        CHECK(route_get(routes, "/users/me/settings", req) == "1", "static route");
+        CHECK(route_get(routes, "/users/me/x", req) == "2" && req.param("id") == "me",
+              "/users/me/x -> id '%.*s'", static_cast<int>(req.param("id").size()), req.param("id").data());
+        CHECK(route_get(routes, "/users/me/posts/7", req) == "3" && req.param("id") == "me" &&
+                  req.param("post") == "7",
+              "dead end two levels down");
+        CHECK(route_get(routes, "/users/me/posts/latest", req) == "4" && req.route_params.count == 0,
+              "static beat params, and stale captures were dropped");
+        CHECK(route_get(routes, "/users/me/set") == "none", "partial static edge matched");
+        CHECK(route_get(routes, "/users//x") == "none", "empty segment matched :id");
+    }
+
+    void test_wildcards_and_mounts() {
+        CORE::RouteSnapshot routes;
+        routes.add_route("GET", "/assets/*path", std::make_shared<IdController>(1));
+        routes.add_mount("GET", "/static/", std::make_shared<IdController>(2));
+
+        CORE::Request req;
+        CHECK(route_get(routes, "/assets/", req) == "1" && req.route_params.count == 1 &&
+                  req.param("path").empty(),
+              "empty wildcard");
+        CHECK(route_get(routes, "/assets/css/site.css?v=3", req) == "1" && req.param("path") == "css/site.css",
+              "wildcard took '%.*s'", static_cast<int>(req.param("path").size()), req.param("path").data());
+        CHECK(route_get(routes, "/assets") == "none", "wildcard matched without its slash");
+
+        CHECK(route_get(routes, "/static", req) == "2" && req.route_params.count == 0, "mount prefix itself");
+        CHECK(route_get(routes, "/static/", req) == "2" && req.param("*").empty() &&
+                  req.route_params.count == 1,
+              "mount prefix with a slash");
+        CHECK(route_get(routes, "/static/js/app.js", req) == "2" && req.param("*") == "js/app.js",
+              "mounted path");
+        CHECK(route_get(routes, "/staticx") == "none", "mount matched a longer name");
+    }
+
+    void test_param_values() {
+        CORE::RouteSnapshot routes;
+        routes.add_route("GET", "/users/:id/posts/:post", std::make_shared<IdController>(1));
+
+        CORE::Request req;
+        CHECK(route_get(routes, "/users/42/posts/7?draft=1", req) == "1", "route with a query");
+        CHECK(req.param("id") == "42" && req.param("post") == "7", "values of two captures");
+        CHECK(req.param("missing").empty(), "unknown name has a value");
+        CHECK(route_get(routes, "/users/a%20b/posts/x", req) == "1" && req.param("id") == "a%20b",
+              "value was decoded");
+
+        // Values are offsets into the path, so they survive the move
+        CORE::Request moved = std::move(req);
+        CHECK(moved.param("post") == "x", "value lost on move");
+
+        CORE::RouteSnapshot deep;
+        deep.add_route("GET", "/:a/:b/:c/:d/:e/:f/:g/*h", std::make_shared<IdController>(8));
+        CHECK(route_get(deep, "/1/2/3/4/5/6/7/8/9", req) == "8" && req.param("a") == "1" &&
+                  req.param("g") == "7" && req.param("h") == "8/9",
+              "MAX_PARAMS captures");
+    }
+
+    void test_rejected_patterns() {
+        auto controller = std::make_shared<IdController>(0);
+        CORE::RouteSnapshot routes;
+        routes.add_route("GET", "/users/:id", controller);
+        routes.add_route("GET", "/files/*rest", controller);
+
+        CHECK(throws_logic_error([&] { routes.add_route("GET", "/users/:name", controller); }),
+              "renamed parameter accepted");
+        CHECK(throws_logic_error([&] { routes.add_route("POST", "/users/:name/posts", controller); }),
+              "renamed parameter under a new suffix accepted");
+        CHECK(throws_logic_error([&] { routes.add_route("GET", "/files/*path", controller); }),
+              "renamed wildcard accepted");
+        CHECK(!throws_logic_error([&] { routes.add_route("POST", "/users/:id/posts", controller); }),
+              "same name under a new suffix rejected");
+
+        CHECK(throws_logic_error([&] { routes.add_route("GET", "/:a/:b/:c/:d/:e/:f/:g/:h/:i", controller); }),
+              "nine captures accepted");
+        CHECK(throws_logic_error([&] { routes.add_route("GET", "/:a/:b/:c/:d/:e/:f/:g/:h/*rest", controller); }),
+              "nine captures with a wildcard accepted");
+        CHECK(!throws_logic_error([&] { routes.add_route("GET", "/:a/:b/:c/:d/:e/:f/:g/:h", controller); }),
+              "MAX_PARAMS captures rejected");
+
+        CHECK(throws_logic_error([&] { routes.add_route("GET", "/users/:/x", controller); }),
+              "unnamed parameter accepted");
+        CHECK(throws_logic_error([&] { routes.add_route("BREW", "/tea", controller); }),
+              "unknown method accepted");
+    }
+
+} // namespace
+
+int main() {
+    std::vector<std::string> paths = generate_paths();
+    CORE::RouteSnapshot routes;
+    for (int i = 0; i < ROUTE_COUNT; ++i) {
+        routes.add_route("GET", paths[i], std::make_shared<IdController>(i));
+    }
+
+    test_every_route_resolves(routes, paths);
+    test_near_misses(routes, paths);
+    test_collision_quality(routes, paths);
+    test_methods_are_separate(routes, paths);
+
+    test_precedence_ignores_insertion_order();
+    test_backtracking();
+    test_wildcards_and_mounts();
+    test_param_values();
+    test_rejected_patterns();
+
+    if (failures) {
+        std::fprintf(stderr, "router_index_test: %d failure(s)\n", failures);
+        return 1;
+    }
+    std::printf("router_index_test: ok\n");
+    return 0;
+}